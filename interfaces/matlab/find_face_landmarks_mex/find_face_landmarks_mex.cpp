@@ -11,6 +11,7 @@
 // sfl
 #include <sfl/sequence_face_landmarks.h>
 #include <sfl/utilities.h>
+#include <sfl/flat_sequence.h>
 
 // OpenCV
 #include <opencv2/core.hpp>
@@ -116,14 +117,16 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 		else throw runtime_error("Second parameter must be either a sequence path or a device id!");
 
 		// Initialize Sequence Face Landmarks
-		if (!landmarksModelPath.empty() && landmarksModelPath != g_landmarksModelPath)
+		// The landmarks model is shared while g_sfl is alive, so creating a new
+		// instance with the same model file does not load it again
+		if (!landmarksModelPath.empty())
 		{
-			//printfFnc("Initializing landmarks model file...\n");
 			g_landmarksModelPath = landmarksModelPath;
 			g_sfl = sfl::SequenceFaceLandmarks::create(landmarksModelPath, frame_scale,
 				(sfl::FaceTrackingType)track);
 		}
-		else g_sfl->clear();
+		else if (g_sfl) g_sfl->clear();
+		else g_sfl = sfl::SequenceFaceLandmarks::create(frame_scale);
 
 		if (landmarksPath.empty())
 		{
@@ -174,7 +177,7 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 		///
 		// Output results
 		///
-		const std::list<std::unique_ptr<sfl::Frame>>& sfl_frames = g_sfl->getSequence();
+		const sfl::FlatSequence& sfl_frames = g_sfl->getFlatSequence();
 
 		// Create the frames as a 1-by-n array of structs.
 		mwSize dims[2] = { 1, 1 };
@@ -184,47 +187,42 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 		plhs[0] = mxCreateStructArray(2, dims, 3, frame_fields);
 
 		// For each frame
-		std::list<std::unique_ptr<sfl::Frame>>::const_iterator it;
-		size_t i = 0;
-		for (it = sfl_frames.begin(); it != sfl_frames.end(); ++it, ++i)
+		for (size_t i = 0; i < sfl_frames.size(); ++i)
 		{
-			const std::unique_ptr<sfl::Frame>& sfl_frame = *it;
+			sfl::FlatSequence::FrameView sfl_frame = sfl_frames[i];
 
 			// Set the width and height to the fields of the current frame
-			mxSetField(plhs[0], i, frame_fields[1], MxArray(sfl_frame->width));
-			mxSetField(plhs[0], i, frame_fields[2], MxArray(sfl_frame->height));
+			mxSetField(plhs[0], i, frame_fields[1], MxArray(sfl_frame.width()));
+			mxSetField(plhs[0], i, frame_fields[2], MxArray(sfl_frame.height()));
 
-			const std::list<std::unique_ptr<sfl::Face>>& faces = sfl_frame->faces;
-			if (faces.empty()) continue;
+			if (sfl_frame.empty()) continue;
 
 			// Create the faces as a 1-by-n array of structs.
-			dims[1] = faces.size();
+			dims[1] = sfl_frame.size();
 			mxArray* facesStructArray = mxCreateStructArray(2, dims, 2, face_fields);
 
 			// Set the faces to the field of the current frame
 			mxSetField(plhs[0], i, frame_fields[0], facesStructArray);
 
 			// For each face
-			std::list<std::unique_ptr<sfl::Face>>::const_iterator face_it;
-			size_t j = 0;
-			for (face_it = faces.begin(); face_it != faces.end(); ++face_it, ++j)
+			for (size_t j = 0; j < sfl_frame.size(); ++j)
 			{
-				const std::unique_ptr<sfl::Face>& face = *face_it;
-				//const sfl::Face& face = sfl_frame->faces[j];
+				sfl::FlatSequence::FaceView face = sfl_frame[j];
 
 				// Convert the landmarks to Matlab's pixel format
-				cv::Mat_<int> landmarks(face->landmarks.size(), 2, (int*)face->landmarks.data());
-				landmarks += 1;
+				cv::Mat_<int> landmarks = cv::Mat_<int>((int)face.landmarksCount(), 2,
+					(int*)face.landmarks()) + 1;
 
 				// Set the landmarks to the field of the current face
 				mxSetField(facesStructArray, j, face_fields[0], MxArray(landmarks));
 
 				// Convert the bounding box to Matlab's pixel format
-				cv::Mat bbox = (cv::Mat_<int>(1, 4) <<
-					face->bbox.x + 1, face->bbox.y + 1, face->bbox.width, face->bbox.height);
+				const cv::Rect& bbox = face.bbox();
+				cv::Mat bbox_mat = (cv::Mat_<int>(1, 4) <<
+					bbox.x + 1, bbox.y + 1, bbox.width, bbox.height);
 
 				// Set the bounding to the field of the current face
-				mxSetField(facesStructArray, j, face_fields[1], MxArray(bbox));
+				mxSetField(facesStructArray, j, face_fields[1], MxArray(bbox_mat));
 			}
 		}
 
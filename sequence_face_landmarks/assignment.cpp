@@ -0,0 +1,84 @@
+#include "assignment.h"
+
+// std
+#include <limits>
+#include <algorithm>
+
+namespace sfl
+{
+    std::vector<int> solveAssignment(const cv::Mat_<double>& costs, double max_cost)
+    {
+        std::vector<int> assignment(costs.rows, -1);
+        if (costs.rows == 0 || costs.cols == 0) return assignment;
+
+        // The algorithm requires rows <= cols
+        bool transposed = costs.rows > costs.cols;
+        cv::Mat_<double> a = transposed ? cv::Mat_<double>(costs.t()) : costs;
+        const int n = a.rows, m = a.cols;
+        const double inf = std::numeric_limits<double>::infinity();
+
+        // Potentials and matching, 1 based with column 0 as a sentinel
+        std::vector<double> u(n + 1, 0), v(m + 1, 0), minv(m + 1);
+        std::vector<int> p(m + 1, 0), way(m + 1, 0);
+        std::vector<char> used(m + 1);
+        for (int i = 1; i <= n; ++i)
+        {
+            // Find an augmenting path from row i
+            p[0] = i;
+            int j0 = 0;
+            std::fill(minv.begin(), minv.end(), inf);
+            std::fill(used.begin(), used.end(), 0);
+            do
+            {
+                used[j0] = 1;
+                int i0 = p[j0], j1 = 0;
+                double delta = inf;
+                const double* row = a[i0 - 1];
+                for (int j = 1; j <= m; ++j)
+                {
+                    if (used[j]) continue;
+                    double cur = std::min(row[j - 1], max_cost) - u[i0] - v[j];
+                    if (cur < minv[j])
+                    {
+                        minv[j] = cur;
+                        way[j] = j0;
+                    }
+                    if (minv[j] < delta)
+                    {
+                        delta = minv[j];
+                        j1 = j;
+                    }
+                }
+                for (int j = 0; j <= m; ++j)
+                {
+                    if (used[j])
+                    {
+                        u[p[j]] += delta;
+                        v[j] -= delta;
+                    }
+                    else minv[j] -= delta;
+                }
+                j0 = j1;
+            } while (p[j0] != 0);
+
+            // Flip the path
+            do
+            {
+                int j1 = way[j0];
+                p[j0] = p[j1];
+                j0 = j1;
+            } while (j0 != 0);
+        }
+
+        // Output the pairs that are not excluded
+        for (int j = 1; j <= m; ++j)
+        {
+            if (p[j] == 0 || a(p[j] - 1, j - 1) >= max_cost) continue;
+            if (transposed) assignment[j - 1] = p[j] - 1;
+            else assignment[p[j] - 1] = j - 1;
+        }
+
+        return assignment;
+    }
+
+}   // namespace sfl
@@ -0,0 +1,25 @@
+#ifndef __SFL_ASSIGNMENT__
+#define __SFL_ASSIGNMENT__
+
+// std
+#include <vector>
+
+// OpenCV
+#include <opencv2/core.hpp>
+
+namespace sfl
+{
+    /** @brief Find the assignment of rows to columns with the minimum total cost.
+    Uses the Hungarian algorithm, O(n^2 * m) for an n x m matrix with n <= m.
+    The matrix does not have to be square, the smaller dimension is fully assigned
+    unless pairs are excluded by max_cost.
+    @param costs Cost matrix, rows are matched with columns.
+    @param max_cost Pairs with a cost greater or equal to this are never assigned.
+    Costs above it are clamped so excluded pairs don't distort the assignment.
+    @return The column assigned to each row, or -1 if the row is not assigned.
+    */
+    std::vector<int> solveAssignment(const cv::Mat_<double>& costs, double max_cost);
+
+}   // namespace sfl
+
+#endif	// __SFL_ASSIGNMENT__
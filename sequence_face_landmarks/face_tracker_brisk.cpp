@@ -1,8 +1,12 @@
 #include "sfl/face_tracker.h"
+#include "assignment.h"
+#include "hamming.h"
 
 // std
 #include <memory>
 #include <exception>
+#include <limits>
+#include <cmath>
 
 // OpenCV
 #include <opencv2/imgproc.hpp>
@@ -12,14 +16,18 @@ using std::runtime_error;
 
 namespace sfl
 {
+    /** Padding around the face bounding box for the keypoints detection.
+    It covers the border BRISK's scale space uses at its coarsest octave.
+    */
+    const int BRISK_DETECT_PADDING = 32;
+
 	struct TrackedFaceBRISK
 	{
 		int id;
 		int frame_id;
 		cv::Rect bbox;
 		std::vector<cv::KeyPoint> landmarks;
-		cv::Mat descriptors;
-		std::vector<int> desc_ind;
+		DescriptorStore descriptors;
 		Face* ref_face;
         cv::Point2f pos;
 	};
@@ -28,8 +36,12 @@ namespace sfl
 	{
 	protected:
 		int m_id_counter = 0;
+        int m_max_age = 0;
+        int m_max_lost = -1;
 		cv::Ptr<cv::Feature2D> m_desc_extractor;
 		std::list<std::unique_ptr<TrackedFaceBRISK>> m_tracked_faces;
+        std::shared_ptr<Profiler> m_profiler;
+        cv::Mat m_mask_buffer;  ///< Detection mask scratch buffer, reused across faces and frames
 		
 	public:
 		FaceTrackerBRISK() : m_desc_extractor(cv::BRISK::create())
@@ -37,7 +49,9 @@ namespace sfl
 		}
 
 		FaceTrackerBRISK(const FaceTrackerBRISK& ft) :
-			m_id_counter(ft.m_id_counter), m_desc_extractor(ft.m_desc_extractor)
+			m_id_counter(ft.m_id_counter), m_max_age(ft.m_max_age), m_max_lost(ft.m_max_lost),
+            m_desc_extractor(ft.m_desc_extractor),
+            m_profiler(ft.m_profiler)
 		{
 			// Deep copy tracked faces
 			for (auto& face : ft.m_tracked_faces)
@@ -46,93 +60,72 @@ namespace sfl
 
 		void addFrame(const cv::Mat& frame, Frame& sfl_frame)
 		{
-			// Convert frame to grayscale
-			cv::Mat frame_gray;
-			if(frame.channels() == 3)
-				cv::cvtColor(frame, frame_gray, cv::COLOR_BGR2GRAY);
-			else frame_gray = frame;
+            FrameContext context(frame, 1.0f, m_profiler.get());
+            addFrame(context, sfl_frame);
+		}
+
+		void addFrame(FrameContext& context, Frame& sfl_frame)
+		{
+            Profiler::ScopedTimer tracking_timer(m_profiler.get(), PROFILE_TRACKING);
+			const cv::Mat& frame_gray = context.getGray();
 
 			// Initialize candidate list
 			std::list<std::unique_ptr<TrackedFaceBRISK>> candidates;
 			for (auto& face : sfl_frame.faces)
 				candidates.push_back(createTrackedFace(frame_gray, *face, sfl_frame.id));
 
-			// For each tracked face
-			double dist, similarity_dist, spatial_dist;
-			cv::Mat_<double> distances(m_tracked_faces.size(), candidates.size());
-			double* distances_data = (double*)distances.data;
-			std::list<std::unique_ptr<TrackedFaceBRISK>>::iterator best_candidate;
-			for (auto& tracked_face : m_tracked_faces)
+			// Compute the distances only for the pairs that are close enough to match.
+            // The distance is the average of the similarity and spatial distances, so
+            // pairs further apart than twice the maximum distance can never match
+            Profiler::ScopedTimer match_timer(m_profiler.get(), PROFILE_BRISK_MATCH);
+            const double max_dist = 250.0;
+            const double max_spatial_dist = 2 * max_dist;
+			double similarity_dist, spatial_dist;
+			cv::Mat_<double> distances(m_tracked_faces.size(), candidates.size(), max_dist);
+            std::vector<std::list<std::unique_ptr<TrackedFaceBRISK>>::iterator> tracked_its, cand_its;
+            tracked_its.reserve(m_tracked_faces.size());
+            cand_its.reserve(candidates.size());
+            for (auto it = m_tracked_faces.begin(); it != m_tracked_faces.end(); ++it)
+                tracked_its.push_back(it);
+            for (auto it = candidates.begin(); it != candidates.end(); ++it)
+                cand_its.push_back(it);
+			for (size_t i = 0; i < tracked_its.size(); ++i)
 			{
-				// For each candidate face
-				std::list<std::unique_ptr<TrackedFaceBRISK>>::iterator it;
-				for (it = candidates.begin(); it != candidates.end(); ++it)
+                TrackedFaceBRISK* tracked_face = tracked_its[i]->get();
+				for (size_t j = 0; j < cand_its.size(); ++j)
 				{
-                    similarity_dist = match(tracked_face.get(), it->get());
-                    spatial_dist = cv::norm(tracked_face->pos - (*it)->pos);
-                    dist = (similarity_dist + spatial_dist)*0.5f;
-					*distances_data++ = dist;
+                    TrackedFaceBRISK* candidate = cand_its[j]->get();
+                    spatial_dist = cv::norm(tracked_face->pos - candidate->pos);
+                    if (spatial_dist >= max_spatial_dist) continue;
+                    similarity_dist = match(tracked_face, candidate);
+                    distances(i, j) = std::min((similarity_dist + spatial_dist)*0.5, max_dist);
 				}
 			}
 
-			// Find matches
-			if (m_tracked_faces.size() > 0)
-			{
-				std::list<std::unique_ptr<TrackedFaceBRISK>>::iterator tracked_it, cand_it;
-				std::list<std::unique_ptr<TrackedFaceBRISK>>::iterator best_tracked_it, best_cand_it;
-				double min_dist = std::numeric_limits<double>::max();
-				const double max_dist = 250.0f;
-				int i, j, best_i, best_j;
-				std::vector<std::pair<std::list<std::unique_ptr<TrackedFaceBRISK>>::iterator,
-					std::list<std::unique_ptr<TrackedFaceBRISK>>::iterator>> matches;
-
-				while (candidates.size() > 0)
-				{
-					min_dist = std::numeric_limits<double>::max();
-
-					for (tracked_it = m_tracked_faces.begin(), i = 0; tracked_it != m_tracked_faces.end(); ++tracked_it, ++i)
-					{
-						for (cand_it = candidates.begin(), j = 0; cand_it != candidates.end(); ++cand_it, ++j)
-						{
-							dist = distances(i, j);
-							if (dist < min_dist && dist < max_dist)
-							{
-								min_dist = dist;
-								best_tracked_it = tracked_it;
-								best_cand_it = cand_it;
-								best_i = i;
-								best_j = j;
-							}
-						}
-					}
-					if (min_dist < max_dist)
-					{
-						// Found match
-						matches.push_back(std::make_pair(best_tracked_it, best_cand_it));
-						if (matches.size() == m_tracked_faces.size() || matches.size() == candidates.size())
-							break;
-						distances(cv::Range(best_i, best_i + 1), cv::Range::all()) = max_dist;
-						distances(cv::Range::all(), cv::Range(best_j, best_j + 1)) = max_dist;
-					}
-					else break;
-				}
+			// Find the matches with the minimum total distance
+            std::vector<int> assignment = solveAssignment(distances, max_dist);
+            for (size_t i = 0; i < assignment.size(); ++i)
+            {
+                if (assignment[i] < 0) continue;
+                std::list<std::unique_ptr<TrackedFaceBRISK>>::iterator& tracked_it = tracked_its[i];
+                std::list<std::unique_ptr<TrackedFaceBRISK>>::iterator& cand_it =
+                    cand_its[assignment[i]];
 
-				// Process matches
-				for (auto& match : matches)
-				{
-					// Set candidate data to matched tracked face
-					(*match.first)->bbox = (*match.second)->bbox;
-					(*match.first)->landmarks = (*match.second)->landmarks;
-					(*match.first)->frame_id = sfl_frame.id;
-					(*match.first)->descriptors = (*match.second)->descriptors;
-					(*match.first)->desc_ind = (*match.second)->desc_ind;
-                    (*match.first)->pos = (*match.second)->pos;
-
-					// Output the tracked id and remove the candidate
-					(*match.second)->ref_face->id = (*match.first)->id;
-					candidates.erase(match.second);
-				}
-			}
+                // Set candidate data to matched tracked face
+                (*tracked_it)->bbox = (*cand_it)->bbox;
+                (*tracked_it)->landmarks = (*cand_it)->landmarks;
+                (*tracked_it)->frame_id = sfl_frame.id;
+                (*tracked_it)->descriptors = std::move((*cand_it)->descriptors);
+                (*tracked_it)->pos = (*cand_it)->pos;
+
+                // Output the tracked id and remove the candidate
+                (*cand_it)->ref_face->id = (*tracked_it)->id;
+                candidates.erase(cand_it);
+
+                // Keep the tracked faces ordered from the least recently seen
+                m_tracked_faces.splice(m_tracked_faces.end(), m_tracked_faces, tracked_it);
+            }
+            match_timer.stop();
 
 			// Add unmatched candidates to tracked faces list
 			std::list<std::unique_ptr<TrackedFaceBRISK>>::iterator it;
@@ -143,6 +136,8 @@ namespace sfl
 				(*it)->ref_face->id = (*it)->id;
 				m_tracked_faces.push_back(std::move(*it));
 			}
+
+            evict(sfl_frame.id);
 		}
 
 		void clear()
@@ -156,7 +151,63 @@ namespace sfl
 			return std::make_shared<FaceTrackerBRISK>(*this);
 		}
 
-	private:	
+        int getMaxAge() const { return m_max_age; }
+
+        int getMaxLost() const { return m_max_lost; }
+
+        void setMaxAge(int frames) { m_max_age = frames; }
+
+        void setMaxLost(int faces) { m_max_lost = faces; }
+
+        void setProfiler(std::shared_ptr<Profiler> profiler)
+        {
+            m_profiler = profiler;
+        }
+
+	private:
+        /** Remove faces that are too old or exceed the maximum number of lost faces.
+        The tracked faces are ordered from the least recently seen, so the lost faces
+        are at the front of the list.
+        */
+        void evict(int frame_id)
+        {
+            int lost = 0;
+            for (auto& face : m_tracked_faces)
+            {
+                if (face->frame_id == frame_id) break;
+                ++lost;
+            }
+
+            while (lost > 0)
+            {
+                const TrackedFaceBRISK& face = *m_tracked_faces.front();
+                bool too_old = m_max_age > 0 && frame_id - face.frame_id > m_max_age;
+                bool too_many = m_max_lost >= 0 && lost > m_max_lost;
+                if (!too_old && !too_many) break;
+                m_tracked_faces.pop_front();
+                --lost;
+            }
+        }
+
+        /** Get a zero mask of the specified size.
+        The mask is a view of the scratch buffer, which only grows when a larger
+        mask is requested.
+        */
+        cv::Mat getMask(const cv::Size& size)
+        {
+            if (m_mask_buffer.rows < size.height || m_mask_buffer.cols < size.width)
+                m_mask_buffer.create(std::max(m_mask_buffer.rows, size.height),
+                    std::max(m_mask_buffer.cols, size.width), CV_8UC1);
+            cv::Mat mask = m_mask_buffer(cv::Rect(cv::Point(0, 0), size));
+            mask.setTo(0);
+            return mask;
+        }
+
+        static cv::Rect padRect(const cv::Rect& r, int pad)
+        {
+            return cv::Rect(r.x - pad, r.y - pad, r.width + 2 * pad, r.height + 2 * pad);
+        }
+
 		std::unique_ptr<TrackedFaceBRISK> createTrackedFace(const cv::Mat& frame_gray,
 			sfl::Face& face, int _frame_id)
 		{
@@ -166,14 +217,18 @@ namespace sfl
 			tracked_face->bbox = face.bbox;
 			tracked_face->ref_face = &face;
 
-			// Find scale
+			// Find scale by detecting keypoints in a padded crop around the face
+			cv::Rect frame_rect(0, 0, frame_gray.cols, frame_gray.rows);
+			cv::Rect bbox = face.bbox & frame_rect;
 			std::vector<cv::KeyPoint> keypoints;
-			cv::Mat mask = cv::Mat_<unsigned char>::zeros(frame_gray.size());
-			cv::Point tl(std::max(face.bbox.tl().x, 0), std::max(face.bbox.tl().y, 0));
-			cv::Point br(std::min(face.bbox.br().x, frame_gray.cols - 1),
-				std::min(face.bbox.br().y, frame_gray.rows - 1));
-			mask(cv::Rect(tl, br)) = 1;
-			m_desc_extractor->detect(frame_gray, keypoints, mask);
+			if (bbox.area() > 0)
+			{
+				cv::Rect detect_roi = padRect(bbox, BRISK_DETECT_PADDING) & frame_rect;
+				cv::Mat mask = getMask(detect_roi.size());
+				mask(bbox - detect_roi.tl()) = 1;
+                Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_BRISK_DETECT);
+                m_desc_extractor->detect(frame_gray(detect_roi), keypoints, mask);
+			}
 			float scale = 0.0f;
 			for (cv::KeyPoint& kp : keypoints) scale += kp.size;
 			if (keypoints.empty()) scale = 10.0f;
@@ -188,21 +243,34 @@ namespace sfl
 				landmarks.push_back(cv::KeyPoint((float)p.x, (float)p.y, scale, 0.0f, 0, i));
 			}
 
-			// Calculate descriptors
-			std::vector<cv::KeyPoint> landmarks_extracted = landmarks;
-			m_desc_extractor->compute(frame_gray, landmarks_extracted,
-				tracked_face->descriptors);
-
-			// Calculate descriptor indices
-			tracked_face->desc_ind.resize(landmarks_extracted.size());
-			int delta;
-			for (int i = 0, j = 0; i < landmarks.size() && j < landmarks_extracted.size(); ++i)
+			// Calculate descriptors in a crop around the landmarks. The padding covers
+			// the BRISK pattern diameter at the keypoints scale, so only the keypoints
+			// at the frame border are removed, same as computing on the full frame.
+			// The keypoints without a descriptor are removed
+			cv::Rect compute_roi = padRect(cv::boundingRect(face.landmarks),
+				2 * (int)std::ceil(scale) + 1) & frame_rect;
+			std::vector<cv::KeyPoint> landmarks_extracted;
+			landmarks_extracted.reserve(landmarks.size());
+			cv::Point2f offset((float)compute_roi.x, (float)compute_roi.y);
+			for (const cv::KeyPoint& kp : landmarks)
 			{
-				cv::Point2f& pt = landmarks[i].pt;
-				cv::Point2f& pt_ex = landmarks_extracted[j].pt;
-				if ((int)std::round(pt.x - pt_ex.x + pt.y - pt_ex.y) != 0) continue;
-				tracked_face->desc_ind[j++] = i;
+				landmarks_extracted.push_back(kp);
+				landmarks_extracted.back().pt -= offset;
 			}
+			cv::Mat descriptors;
+            if (compute_roi.area() > 0)
+            {
+                Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_BRISK_COMPUTE);
+                m_desc_extractor->compute(frame_gray(compute_roi), landmarks_extracted,
+                    descriptors);
+            }
+            else landmarks_extracted.clear();
+
+			// Store each descriptor in the slot of its landmark
+			std::vector<int> desc_ind(landmarks_extracted.size());
+			for (size_t i = 0; i < landmarks_extracted.size(); ++i)
+				desc_ind[i] = landmarks_extracted[i].class_id;
+			tracked_face->descriptors.assign(descriptors, desc_ind, (int)landmarks.size());
 
             // Calculate position
             for (const cv::KeyPoint& kp : tracked_face->landmarks)
@@ -214,23 +282,10 @@ namespace sfl
 
 		double match(TrackedFaceBRISK* face1, TrackedFaceBRISK* face2)
 		{
-			double dist, avg_dist = 0;
-			int di, dj, total = 0;
-			for (int i = 0, j = 0; i < face1->descriptors.rows && j < face2->descriptors.rows;)
-			{
-				di = face1->desc_ind[i];
-				dj = face2->desc_ind[j];
-				if (di < dj) ++i;
-				else if (di > dj) ++j;
-				else
-				{
-					dist = cv::norm(face1->descriptors.row(i), face2->descriptors.row(j), cv::NORM_HAMMING);
-					avg_dist += dist;
-					++i; ++j, ++total;
-				}
-			}
-
-			return avg_dist / total;
+			int total;
+			int dist = hammingDistance(face1->descriptors, face2->descriptors, total);
+            if (total == 0) return std::numeric_limits<double>::max();
+			return (double)dist / total;
 		}
 	};
 
@@ -1,5 +1,6 @@
 #include "sfl/face_tracker.h"
 #include "sfl/utilities.h"
+#include "lbp.h"
 
 // std
 #include <memory>
@@ -12,42 +13,46 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/features2d.hpp>
 
-#ifdef WITH_OPENCV_CONTRIB
-#include <opencv2/face.hpp>
-#endif
-
 using std::runtime_error;
 
 namespace sfl
 {
-#ifdef WITH_OPENCV_CONTRIB
+    /** Size of the LBP spatial histograms, 8 x 8 grid of 256 bins histograms.
+    */
+    const int LBP_HISTOGRAM_SIZE = 8 * 8 * 256;
 
     struct TrackedFaceLBP
     {
         int id;
         int frame_id;
-        cv::Ptr<cv::face::LBPHFaceRecognizer> model;
+        int model = -1;         ///< Index of the face's LBP histogram in the models store.
+        int model_samples = 0;  ///< Number of histograms in the running mean.
         cv::Point2f pos;
         bool tracking_lost = false;
     };
 
     struct CandidateFace
     {
-        cv::Mat frame;
+        cv::Mat histogram;
         cv::Point2f pos;
     };
 
     class FaceTrackerLBP : public FaceTracker
     {
     public:
-        FaceTrackerLBP()
+        FaceTrackerLBP() : m_models(LBP_HISTOGRAM_SIZE)
         {
         }
 
         FaceTrackerLBP(const FaceTrackerLBP& ft) :
             m_id_counter(ft.m_id_counter),
             m_tracking_lost_range(ft.m_tracking_lost_range),
-            m_verbose(ft.m_verbose)
+            m_max_age(ft.m_max_age),
+            m_max_lost(ft.m_max_lost),
+            m_model_history(ft.m_model_history),
+            m_verbose(ft.m_verbose),
+            m_models(ft.m_models.clone()),
+            m_profiler(ft.m_profiler)
         {
             // Deep copy tracked faces
             for (auto& face : ft.m_tracked_faces)
@@ -64,9 +69,17 @@ namespace sfl
 
         void addFrame(const cv::Mat& frame, Frame& sfl_frame)
         {
+            FrameContext context(frame, 1.0f, m_profiler.get());
+            addFrame(context, sfl_frame);
+        }
+
+        void addFrame(FrameContext& context, Frame& sfl_frame)
+        {
+            Profiler::ScopedTimer tracking_timer(m_profiler.get(), PROFILE_TRACKING);
+
             // Create candidate faces
             std::vector<CandidateFace> candidates;
-            createCandidateFaces(frame, sfl_frame, candidates);
+            createCandidateFaces(context, sfl_frame, candidates);
 
             // Create sfl faces vector
             std::vector<Face*> sfl_faces;
@@ -130,12 +143,16 @@ namespace sfl
                     createTrackedFace(candidates[cand_ind], sfl_frame.id));
                 sfl_faces[cand_ind]->id = m_tracked_faces.back()->id;
             }
+
+            evict(sfl_frame.id);
         }
 
         void clear()
         {
             m_id_counter = 0;
             m_tracked_faces.clear();
+            m_lost_faces.clear();
+            m_models.clear();
         }
 
         std::shared_ptr<FaceTracker> clone()
@@ -143,35 +160,65 @@ namespace sfl
             return std::make_shared<FaceTrackerLBP>(*this);
         }
 
+        int getMaxAge() const { return m_max_age; }
+
+        int getMaxLost() const { return m_max_lost; }
+
+        void setMaxAge(int frames) { m_max_age = frames; }
+
+        void setMaxLost(int faces) { m_max_lost = faces; }
+
+        void setProfiler(std::shared_ptr<Profiler> profiler)
+        {
+            m_profiler = profiler;
+        }
+
     private:
-        void createCandidateFaces(const cv::Mat& frame, const Frame& sfl_frame,
+        /** Remove lost faces that are too old or exceed the maximum number of lost faces.
+        Faces are appended to the lost faces list when they are lost, so the list is
+        ordered from the least recently seen.
+        */
+        void evict(int frame_id)
+        {
+            while (!m_lost_faces.empty())
+            {
+                const TrackedFaceLBP& face = *m_lost_faces.front();
+                bool too_old = m_max_age > 0 && frame_id - face.frame_id > m_max_age;
+                bool too_many = m_max_lost >= 0 && (int)m_lost_faces.size() > m_max_lost;
+                if (!too_old && !too_many) break;
+                if (m_verbose)
+                    std::cout << "Evicting lost face " << face.id << std::endl;
+                m_models.remove(face.model);
+                m_lost_faces.pop_front();
+            }
+        }
+
+        void createCandidateFaces(FrameContext& context, const Frame& sfl_frame,
             std::vector<CandidateFace>& candidates) const
         {
             const cv::Size frame_size(128, 128);
+            const cv::Mat& gray = context.getGray();
+            const cv::Rect frame_rect(0, 0, gray.cols, gray.rows);
 
-            // Convert frame to grayscale
-            cv::Mat frame_gray;
-            if (frame.channels() == 3)
-                cv::cvtColor(frame, frame_gray, cv::COLOR_BGR2GRAY);
-            else frame_gray = frame;
+            // The candidates' histograms are computed once into a single matrix
+            cv::Mat histograms(std::max((int)sfl_frame.faces.size(), 1),
+                LBP_HISTOGRAM_SIZE, CV_32F);
 
             // For each face
             candidates.reserve(sfl_frame.faces.size());
             for (auto& face : sfl_frame.faces)
             {
                 CandidateFace candidate;
+                candidate.histogram = histograms.row((int)candidates.size());
 
-                // Calculate frame
+                // Calculate histogram, the crop is not needed afterwards
                 std::vector<cv::Point> full_face;
                 createFullFace(face->landmarks, full_face);
-                cv::Rect bbox = cv::boundingRect(full_face);
-                bbox.x = std::max(bbox.x, 0);
-                bbox.y = std::max(bbox.y, 0);
-                bbox.width = std::min(bbox.width, frame_gray.cols - bbox.x);
-                bbox.height = std::min(bbox.height, frame_gray.rows - bbox.y);
-                cv::Mat frame_gray_cropped = frame_gray(bbox);
-                cv::resize(frame_gray_cropped, frame_gray_cropped, frame_size);
-                candidate.frame = frame_gray_cropped;
+                cv::Rect roi = cv::boundingRect(full_face) & frame_rect;
+                cv::Mat crop;
+                if (roi.area() > 0) cv::resize(gray(roi), crop, frame_size);
+                else crop = cv::Mat::zeros(frame_size, CV_8UC1);
+                computeLBPHistogram(crop, candidate.histogram);
 
                 // Calculate position
                 if (face->landmarks.size() > 0)
@@ -193,51 +240,77 @@ namespace sfl
             std::unique_ptr<TrackedFaceLBP> tracked_face = std::make_unique<TrackedFaceLBP>();
             tracked_face->id = m_id_counter++;
             tracked_face->frame_id = frame_id;
-			
-			// Note: LBPHFaceRecognizer interface changed in OpenCV version 3.3.0
-#if CV_MAJOR_VERSION <= 3 && CV_MINOR_VERSION <= 2
-            //tracked_face->model = cv::face::createLBPHFaceRecognizer(3, 8, 8, 8);
-#else
-			tracked_face->model = cv::face::LBPHFaceRecognizer::create(3, 8, 8, 8);
-#endif
             tracked_face->pos = candidate.pos;
             tracked_face->tracking_lost = false;
 
-            // Train initial model
-            std::vector<cv::Mat> face_frames = { candidate.frame };
-            std::vector<int> labels = { tracked_face->id };
-            tracked_face->model->train(face_frames, labels);
+            // Initial model
+            Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_LBP_UPDATE);
+            updateModel(*tracked_face, candidate);
+            timer.stop();
 
             return tracked_face;
         }
 
-        double calc_dist(const TrackedFaceLBP& face, const CandidateFace& candidate) const
+        /** Add a candidate's histogram to a face's appearance model.
+        The model is the mean of the face's histograms. After m_model_history samples
+        it becomes an exponential moving average, so the model's size and the cost of
+        comparing with it are constant regardless of how long the face is tracked.
+        */
+        void updateModel(TrackedFaceLBP& face, const CandidateFace& candidate)
         {
-            int label;
-            double dist, similarity_dist, spatial_dist;
-            face.model->predict(candidate.frame, label, similarity_dist);
-            spatial_dist = cv::norm(face.pos - candidate.pos);
-            if (!face.tracking_lost && spatial_dist <= 30.0f)
-                dist = (similarity_dist + spatial_dist)*0.5f;
-            else dist = similarity_dist;
-            return dist;
+            if (face.model < 0)
+            {
+                face.model = m_models.add(candidate.histogram);
+                face.model_samples = 1;
+                return;
+            }
+            face.model_samples = std::min(face.model_samples + 1, m_model_history);
+            const float alpha = 1.0f / face.model_samples;
+            float* model = m_models.get(face.model);
+            const float* hist = candidate.histogram.ptr<float>();
+            for (int i = 0; i < m_models.size(); ++i)
+                model[i] += alpha * (hist[i] - model[i]);
         }
 
+        /** Calculate the distances between the faces and the remaining candidates.
+        The chi-square distances of all the pairs are computed in a single pass over
+        the faces' models and the candidates' histograms.
+        */
         cv::Mat calc_dist(const std::list<std::unique_ptr<TrackedFaceLBP>>& faces,
             const std::vector<CandidateFace>& candidates,
             std::set<size_t>& cand_indices) const
         {
             if (faces.empty() || cand_indices.empty()) return cv::Mat();
 
-            cv::Mat dists = cv::Mat_<double>::zeros(faces.size(), candidates.size());
-            double* dists_data = (double*)dists.data;
+            // Gather the histograms
+            std::vector<const float*> face_hists, cand_hists;
+            face_hists.reserve(faces.size());
+            for (auto& tracked_face : faces)
+                face_hists.push_back(m_models.get(tracked_face->model));
+            cand_hists.reserve(cand_indices.size());
+            for (size_t cand_ind : cand_indices)
+                cand_hists.push_back(candidates[cand_ind].histogram.ptr<float>());
+
+            // Similarity distances
+            cv::Mat_<double> dists(faces.size(), cand_indices.size());
+            {
+                Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_LBP_PREDICT);
+                chiSquareDistances(face_hists.data(), (int)face_hists.size(),
+                    cand_hists.data(), (int)cand_hists.size(), m_models.size(),
+                    (double*)dists.data);
+            }
 
-            // For each tracked face
+            // Add spatial distances of faces that are still tracked
+            double* dists_data = (double*)dists.data;
             for (auto& tracked_face : faces)
             {
-                // For each candidate
                 for (size_t cand_ind : cand_indices)
-                    *dists_data++ = calc_dist(*tracked_face, candidates[cand_ind]);
+                {
+                    double spatial_dist = cv::norm(tracked_face->pos - candidates[cand_ind].pos);
+                    if (!tracked_face->tracking_lost && spatial_dist <= 30.0f)
+                        *dists_data = (*dists_data + spatial_dist)*0.5f;
+                    ++dists_data;
+                }
             }
 
             if (m_verbose)
@@ -246,7 +319,7 @@ namespace sfl
                 for (auto& tracked_face : faces)
                 {
                     std::cout << "face " << tracked_face->id << ": ";
-                    for (const CandidateFace& cand : candidates)
+                    for (size_t j = 0; j < cand_indices.size(); ++j)
                         std::cout << *dists_data++ << " ";
                     std::cout << std::endl;
                 }
@@ -304,11 +377,9 @@ namespace sfl
                 cand_indices.erase(cand_it);
                 TrackedFaceLBP* tracked_face = tracked_faces[tracked_ind];
                 tracked_face->frame_id = frame_id;
-                //tracked_face->model->clear();
-                std::vector<cv::Mat> train_frames = { candidates[cand_ind].frame };
-                std::vector<int> labels = { tracked_face->id };
-                //tracked_face->model->train(train_frames, labels);
-                tracked_face->model->update(train_frames, labels);
+                Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_LBP_UPDATE);
+                updateModel(*tracked_face, candidates[cand_ind]);
+                timer.stop();
                 tracked_face->pos = candidates[cand_ind].pos;
                 tracked_face->tracking_lost = false;
                 sfl_faces[cand_ind]->id = tracked_face->id;
@@ -318,9 +389,14 @@ namespace sfl
     protected:
         int m_id_counter = 0;
         int m_tracking_lost_range = 10;
+        int m_max_age = 0;
+        int m_max_lost = -1;
+        int m_model_history = 30;
         bool m_verbose = false;
+        HistogramStore m_models;
         std::list<std::unique_ptr<TrackedFaceLBP>> m_tracked_faces;
         std::list<std::unique_ptr<TrackedFaceLBP>> m_lost_faces;
+        std::shared_ptr<Profiler> m_profiler;
     };
 
     std::shared_ptr<FaceTracker> createFaceTrackerLBP()
@@ -328,14 +404,5 @@ namespace sfl
         return std::make_shared<FaceTrackerLBP>();
     }
 
-#else
-    std::shared_ptr<FaceTracker> createFaceTrackerLBP()
-    {
-        throw std::runtime_error("LBP face tracked is not available!"
-            " Please build with OpenCV's extra modules.");
-        return nullptr;
-    }
-#endif
-
 }   // namespace sfl
 
@@ -0,0 +1,229 @@
+#include "sfl/face_tracker.h"
+#include "assignment.h"
+
+// std
+#include <memory>
+#include <algorithm>
+
+namespace sfl
+{
+    /** Minimum overlap between a face's predicted bounding box and a candidate's
+    bounding box for them to match.
+    */
+    const double MOTION_MIN_IOU = 0.3;
+
+    /** Maximum number of frames a lost face's motion is extrapolated.
+    */
+    const int MOTION_MAX_PREDICTION = 10;
+
+    /** Weight of the latest velocity measurement in the velocity estimate.
+    */
+    const float MOTION_VELOCITY_WEIGHT = 0.5f;
+
+    struct TrackedFaceMotion
+    {
+        int id;
+        int frame_id;
+        cv::Rect bbox;
+        cv::Point2f pos;        ///< Landmarks centroid.
+        cv::Point2f velocity;   ///< Centroid motion per frame.
+    };
+
+    /** Tracks faces by their motion only.
+    Each face follows a constant velocity model of its landmarks centroid. The
+    faces are matched to their predicted bounding boxes by overlap, so no pixels
+    are accessed and the frame may be empty.
+    */
+    class FaceTrackerMotion : public FaceTracker
+    {
+    protected:
+        int m_id_counter = 0;
+        int m_max_age = 0;
+        int m_max_lost = -1;
+        std::list<std::unique_ptr<TrackedFaceMotion>> m_tracked_faces;
+        std::shared_ptr<Profiler> m_profiler;
+
+    public:
+        FaceTrackerMotion()
+        {
+        }
+
+        FaceTrackerMotion(const FaceTrackerMotion& ft) :
+            m_id_counter(ft.m_id_counter), m_max_age(ft.m_max_age), m_max_lost(ft.m_max_lost),
+            m_profiler(ft.m_profiler)
+        {
+            // Deep copy tracked faces
+            for (auto& face : ft.m_tracked_faces)
+                m_tracked_faces.push_back(std::make_unique<TrackedFaceMotion>(*face));
+        }
+
+        void addFrame(const cv::Mat& frame, Frame& sfl_frame)
+        {
+            track(sfl_frame);
+        }
+
+        void addFrame(FrameContext& context, Frame& sfl_frame)
+        {
+            track(sfl_frame);
+        }
+
+        void clear()
+        {
+            m_id_counter = 0;
+            m_tracked_faces.clear();
+        }
+
+        std::shared_ptr<FaceTracker> clone()
+        {
+            return std::make_shared<FaceTrackerMotion>(*this);
+        }
+
+        int getMaxAge() const { return m_max_age; }
+
+        int getMaxLost() const { return m_max_lost; }
+
+        void setMaxAge(int frames) { m_max_age = frames; }
+
+        void setMaxLost(int faces) { m_max_lost = faces; }
+
+        void setProfiler(std::shared_ptr<Profiler> profiler)
+        {
+            m_profiler = profiler;
+        }
+
+    private:
+        void track(Frame& sfl_frame)
+        {
+            Profiler::ScopedTimer tracking_timer(m_profiler.get(), PROFILE_TRACKING);
+
+            // Measure candidates
+            std::vector<Face*> candidates;
+            std::vector<cv::Point2f> positions;
+            candidates.reserve(sfl_frame.faces.size());
+            positions.reserve(sfl_frame.faces.size());
+            for (auto& face : sfl_frame.faces)
+            {
+                candidates.push_back(face.get());
+                positions.push_back(centroid(*face));
+            }
+
+            // Predict the tracked faces' bounding boxes and compare them to the candidates
+            const double max_cost = 1.0 - MOTION_MIN_IOU;
+            std::vector<std::list<std::unique_ptr<TrackedFaceMotion>>::iterator> tracked_its;
+            tracked_its.reserve(m_tracked_faces.size());
+            cv::Mat_<double> costs(m_tracked_faces.size(), candidates.size(), max_cost);
+            for (auto it = m_tracked_faces.begin(); it != m_tracked_faces.end(); ++it)
+            {
+                int i = (int)tracked_its.size();
+                tracked_its.push_back(it);
+                cv::Rect2f predicted = predict(**it, sfl_frame.id);
+                for (size_t j = 0; j < candidates.size(); ++j)
+                    costs(i, (int)j) = std::min(1.0 - iou(predicted,
+                        cv::Rect2f(candidates[j]->bbox)), max_cost);
+            }
+
+            // Find the matches with the maximum total overlap
+            std::vector<int> assignment = solveAssignment(costs, max_cost);
+            std::vector<bool> matched(candidates.size(), false);
+            for (size_t i = 0; i < assignment.size(); ++i)
+            {
+                if (assignment[i] < 0) continue;
+                auto& tracked_it = tracked_its[i];
+                TrackedFaceMotion& tracked_face = **tracked_it;
+                int j = assignment[i];
+
+                // Update the motion model
+                int dt = std::max(sfl_frame.id - tracked_face.frame_id, 1);
+                cv::Point2f measured = (positions[j] - tracked_face.pos) / (float)dt;
+                tracked_face.velocity = tracked_face.velocity * (1.0f - MOTION_VELOCITY_WEIGHT) +
+                    measured * MOTION_VELOCITY_WEIGHT;
+                tracked_face.pos = positions[j];
+                tracked_face.bbox = candidates[j]->bbox;
+                tracked_face.frame_id = sfl_frame.id;
+
+                // Output the tracked id
+                candidates[j]->id = tracked_face.id;
+                matched[j] = true;
+
+                // Keep the tracked faces ordered from the least recently seen
+                m_tracked_faces.splice(m_tracked_faces.end(), m_tracked_faces, tracked_it);
+            }
+
+            // Add unmatched candidates as new tracked faces
+            for (size_t j = 0; j < candidates.size(); ++j)
+            {
+                if (matched[j]) continue;
+                std::unique_ptr<TrackedFaceMotion> face = std::make_unique<TrackedFaceMotion>();
+                face->id = m_id_counter++;
+                face->frame_id = sfl_frame.id;
+                face->bbox = candidates[j]->bbox;
+                face->pos = positions[j];
+                candidates[j]->id = face->id;
+                m_tracked_faces.push_back(std::move(face));
+            }
+
+            evict(sfl_frame.id);
+        }
+
+        /** Remove faces that are too old or exceed the maximum number of lost faces.
+        The tracked faces are ordered from the least recently seen, so the lost faces
+        are at the front of the list.
+        */
+        void evict(int frame_id)
+        {
+            int lost = 0;
+            for (auto& face : m_tracked_faces)
+            {
+                if (face->frame_id == frame_id) break;
+                ++lost;
+            }
+
+            while (lost > 0)
+            {
+                const TrackedFaceMotion& face = *m_tracked_faces.front();
+                bool too_old = m_max_age > 0 && frame_id - face.frame_id > m_max_age;
+                bool too_many = m_max_lost >= 0 && lost > m_max_lost;
+                if (!too_old && !too_many) break;
+                m_tracked_faces.pop_front();
+                --lost;
+            }
+        }
+
+        /** Predict the face's bounding box in the specified frame.
+        */
+        static cv::Rect2f predict(const TrackedFaceMotion& face, int frame_id)
+        {
+            int dt = std::min(std::max(frame_id - face.frame_id, 0), MOTION_MAX_PREDICTION);
+            cv::Rect2f bbox(face.bbox);
+            bbox.x += face.velocity.x * dt;
+            bbox.y += face.velocity.y * dt;
+            return bbox;
+        }
+
+        /** Landmarks centroid, or the bounding box center if there are no landmarks.
+        */
+        static cv::Point2f centroid(const Face& face)
+        {
+            if (face.landmarks.empty())
+                return cv::Point2f(face.bbox.x + face.bbox.width * 0.5f,
+                    face.bbox.y + face.bbox.height * 0.5f);
+            cv::Point2f pos;
+            for (const cv::Point& p : face.landmarks)
+                pos += cv::Point2f((float)p.x, (float)p.y);
+            return pos / (float)face.landmarks.size();
+        }
+
+        static double iou(const cv::Rect2f& r1, const cv::Rect2f& r2)
+        {
+            double intersection = (r1 & r2).area();
+            double area = r1.area() + r2.area() - intersection;
+            return area > 0 ? intersection / area : 0.0;
+        }
+    };
+
+    std::shared_ptr<FaceTracker> createFaceTrackerMotion()
+    {
+        return std::make_shared<FaceTrackerMotion>();
+    }
+
+}   // namespace sfl
@@ -0,0 +1,114 @@
+#include "sfl/flat_sequence.h"
+
+namespace sfl
+{
+    void FlatSequence::FaceView::copyTo(Face& face) const
+    {
+        face.id = id();
+        face.bbox = bbox();
+        face.landmarks.assign(landmarks(), landmarks() + landmarksCount());
+    }
+
+    int FlatSequence::FrameView::findFace(int id) const
+    {
+        const int* ids = m_sequence->m_face_ids.data() + m_sequence->m_frame_offsets[m_index];
+        for (size_t j = 0, n = size(); j < n; ++j)
+            if (ids[j] == id) return (int)j;
+        return -1;
+    }
+
+    void FlatSequence::FrameView::copyTo(Frame& frame) const
+    {
+        frame.id = id();
+        frame.width = width();
+        frame.height = height();
+        frame.faces.clear();
+        for (size_t j = 0, n = size(); j < n; ++j)
+        {
+            std::unique_ptr<Face> face = std::make_unique<Face>();
+            (*this)[j].copyTo(*face);
+            frame.faces.push_back(std::move(face));
+        }
+    }
+
+    FlatSequence::FlatSequence() : m_frame_offsets(1, 0), m_landmark_offsets(1, 0)
+    {
+    }
+
+    FlatSequence::FlatSequence(const std::list<std::unique_ptr<Frame>>& sequence) :
+        FlatSequence()
+    {
+        assign(sequence);
+    }
+
+    void FlatSequence::assign(const std::list<std::unique_ptr<Frame>>& sequence)
+    {
+        clear();
+
+        // Count everything first so each array is allocated once
+        size_t faces = 0, landmarks = 0;
+        for (auto& frame : sequence)
+        {
+            faces += frame->faces.size();
+            for (auto& face : frame->faces)
+                landmarks += face->landmarks.size();
+        }
+        reserve(sequence.size(), faces, landmarks);
+
+        for (auto& frame : sequence)
+            append(*frame);
+    }
+
+    void FlatSequence::append(const Frame& frame)
+    {
+        m_frame_ids.push_back(frame.id);
+        m_frame_widths.push_back(frame.width);
+        m_frame_heights.push_back(frame.height);
+
+        for (auto& face : frame.faces)
+        {
+            m_face_ids.push_back(face->id);
+            m_face_bboxes.push_back(face->bbox);
+            m_landmarks.insert(m_landmarks.end(),
+                face->landmarks.begin(), face->landmarks.end());
+            m_landmark_offsets.push_back(m_landmarks.size());
+        }
+        m_frame_offsets.push_back(m_face_ids.size());
+    }
+
+    void FlatSequence::clear()
+    {
+        m_frame_ids.clear();
+        m_frame_widths.clear();
+        m_frame_heights.clear();
+        m_frame_offsets.assign(1, 0);
+        m_face_ids.clear();
+        m_face_bboxes.clear();
+        m_landmark_offsets.assign(1, 0);
+        m_landmarks.clear();
+    }
+
+    void FlatSequence::reserve(size_t frames, size_t faces, size_t landmarks)
+    {
+        m_frame_ids.reserve(frames);
+        m_frame_widths.reserve(frames);
+        m_frame_heights.reserve(frames);
+        m_frame_offsets.reserve(frames + 1);
+        m_face_ids.reserve(faces);
+        m_face_bboxes.reserve(faces);
+        m_landmark_offsets.reserve(faces + 1);
+        m_landmarks.reserve(landmarks);
+    }
+
+    void FlatSequence::copyTo(std::list<std::unique_ptr<Frame>>& sequence) const
+    {
+        sequence.clear();
+        for (size_t i = 0; i < size(); ++i)
+        {
+            std::unique_ptr<Frame> frame = std::make_unique<Frame>();
+            (*this)[i].copyTo(*frame);
+            sequence.push_back(std::move(frame));
+        }
+    }
+
+}   // namespace sfl
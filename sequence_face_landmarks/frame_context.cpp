@@ -0,0 +1,50 @@
+#include "sfl/frame_context.h"
+
+// OpenCV
+#include <opencv2/imgproc.hpp>
+
+namespace sfl
+{
+    FrameContext::FrameContext(const cv::Mat& frame, float scale, Profiler* profiler) :
+        m_frame(frame), m_scale(scale), m_profiler(profiler)
+    {
+    }
+
+    const cv::Mat& FrameContext::getGray()
+    {
+        if (!m_gray.empty() || m_frame.empty()) return m_gray;
+        if (m_frame.channels() == 3)
+        {
+            Profiler::ScopedTimer timer(m_profiler, PROFILE_COLOR_CONVERSION);
+            cv::cvtColor(m_frame, m_gray, cv::COLOR_BGR2GRAY);
+        }
+        else m_gray = m_frame;
+        return m_gray;
+    }
+
+    const cv::Mat& FrameContext::getScaled()
+    {
+        if (!m_scaled.empty() || m_frame.empty()) return m_scaled;
+        if (m_scale != 1.0f)
+        {
+            Profiler::ScopedTimer timer(m_profiler, PROFILE_RESIZE);
+            cv::resize(m_frame, m_scaled, cv::Size(), m_scale, m_scale);
+        }
+        else m_scaled = m_frame;
+        return m_scaled;
+    }
+
+    const cv::Mat& FrameContext::getScaledGray()
+    {
+        if (!m_scaled_gray.empty() || m_frame.empty()) return m_scaled_gray;
+        if (m_scale == 1.0f) m_scaled_gray = getGray();
+        else if (m_frame.channels() == 3)
+        {
+            Profiler::ScopedTimer timer(m_profiler, PROFILE_COLOR_CONVERSION);
+            cv::cvtColor(getScaled(), m_scaled_gray, cv::COLOR_BGR2GRAY);
+        }
+        else m_scaled_gray = getScaled();
+        return m_scaled_gray;
+    }
+
+}   // namespace sfl
@@ -0,0 +1,147 @@
+#include "hamming.h"
+
+// std
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#ifdef SFL_X64
+#include <immintrin.h>
+#endif
+
+using std::runtime_error;
+
+namespace sfl
+{
+    const int DESC_SIZE = DescriptorStore::DESCRIPTOR_SIZE;
+
+    void DescriptorStore::allocate(int slots)
+    {
+        m_data.resize(slots * DESC_SIZE);
+        m_valid.assign(slots, 0);
+    }
+
+    void DescriptorStore::assign(const cv::Mat& descriptors,
+        const std::vector<int>& indices, int slots)
+    {
+        if (!descriptors.empty() && (descriptors.type() != CV_8UC1 ||
+            descriptors.cols != DESC_SIZE))
+            throw runtime_error("Descriptors must be 64 bytes binary descriptors!");
+        allocate(slots);
+        for (int i = 0; i < descriptors.rows && i < (int)indices.size(); ++i)
+        {
+            int slot = indices[i];
+            if (slot < 0 || slot >= slots) continue;
+            std::memcpy(m_data.data() + slot * DESC_SIZE, descriptors.ptr(i), DESC_SIZE);
+            m_valid[slot] = 1;
+        }
+    }
+
+    static inline int popcount64(uint64_t x)
+    {
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (int)((x * 0x0101010101010101ULL) >> 56);
+    }
+
+    static int hammingScalar(const uint8_t* a, const uint8_t* b,
+        const uint8_t* valid_a, const uint8_t* valid_b, int slots, int& pairs)
+    {
+        int dist = 0;
+        pairs = 0;
+        for (int i = 0; i < slots; ++i)
+        {
+            if (!(valid_a[i] & valid_b[i])) continue;
+            const uint8_t* pa = a + i * DESC_SIZE;
+            const uint8_t* pb = b + i * DESC_SIZE;
+            for (int k = 0; k < DESC_SIZE; k += 8)
+            {
+                uint64_t x, y;
+                std::memcpy(&x, pa + k, 8);
+                std::memcpy(&y, pb + k, 8);
+                dist += popcount64(x ^ y);
+            }
+            ++pairs;
+        }
+        return dist;
+    }
+
+#ifdef SFL_X64
+    SFL_TARGET("popcnt")
+    static int hammingPOPCNT(const uint8_t* a, const uint8_t* b,
+        const uint8_t* valid_a, const uint8_t* valid_b, int slots, int& pairs)
+    {
+        int64_t dist = 0;
+        pairs = 0;
+        for (int i = 0; i < slots; ++i)
+        {
+            if (!(valid_a[i] & valid_b[i])) continue;
+            const uint64_t* pa = (const uint64_t*)(a + i * DESC_SIZE);
+            const uint64_t* pb = (const uint64_t*)(b + i * DESC_SIZE);
+            for (int k = 0; k < DESC_SIZE / 8; ++k)
+                dist += _mm_popcnt_u64(pa[k] ^ pb[k]);
+            ++pairs;
+        }
+        return (int)dist;
+    }
+
+    SFL_TARGET("avx2")
+    static int hammingAVX2(const uint8_t* a, const uint8_t* b,
+        const uint8_t* valid_a, const uint8_t* valid_b, int slots, int& pairs)
+    {
+        // Per nibble bit counts
+        const __m256i lookup = _mm256_setr_epi8(
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low_mask = _mm256_set1_epi8(0x0f);
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i acc = _mm256_setzero_si256();
+        pairs = 0;
+        for (int i = 0; i < slots; ++i)
+        {
+            if (!(valid_a[i] & valid_b[i])) continue;
+            const __m256i* pa = (const __m256i*)(a + i * DESC_SIZE);
+            const __m256i* pb = (const __m256i*)(b + i * DESC_SIZE);
+            for (int k = 0; k < DESC_SIZE / 32; ++k)
+            {
+                __m256i x = _mm256_xor_si256(_mm256_load_si256(pa + k),
+                    _mm256_load_si256(pb + k));
+                __m256i lo = _mm256_and_si256(x, low_mask);
+                __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask);
+                __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                    _mm256_shuffle_epi8(lookup, hi));
+                acc = _mm256_add_epi64(acc, _mm256_sad_epu8(counts, zero));
+            }
+            ++pairs;
+        }
+        return (int)(_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+            _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+    }
+#endif
+
+    typedef int(*HammingKernel)(const uint8_t*, const uint8_t*,
+        const uint8_t*, const uint8_t*, int, int&);
+
+    static HammingKernel selectHammingKernel()
+    {
+#ifdef SFL_X64
+        if (cv::checkHardwareSupport(CV_CPU_AVX2)) return hammingAVX2;
+        if (cv::checkHardwareSupport(CV_CPU_POPCNT)) return hammingPOPCNT;
+#endif
+        return hammingScalar;
+    }
+
+    int hammingDistance(const DescriptorStore& a, const DescriptorStore& b, int& pairs)
+    {
+        static const HammingKernel kernel = selectHammingKernel();
+        int slots = std::min(a.slots(), b.slots());
+        if (slots == 0)
+        {
+            pairs = 0;
+            return 0;
+        }
+        return kernel(a.data(), b.data(), a.validData(), b.validData(), slots, pairs);
+    }
+
+}   // namespace sfl
@@ -0,0 +1,65 @@
+#ifndef __SFL_HAMMING__
+#define __SFL_HAMMING__
+
+// std
+#include <vector>
+#include <cstdint>
+
+// OpenCV
+#include <opencv2/core.hpp>
+
+// sfl
+#include "simd.h"
+
+namespace sfl
+{
+    /** @brief Binary descriptors of a face's landmarks.
+    Each landmark has a fixed 64 bytes slot (the size of a BRISK descriptor) in a
+    single 64 bytes aligned buffer, so the descriptors of two faces are compared
+    slot by slot without searching for common landmarks.
+    */
+    class DescriptorStore
+    {
+    public:
+        static const int DESCRIPTOR_SIZE = 64;
+
+        /** @brief Set the descriptors.
+        @param descriptors Descriptors matrix [CV_8UC1, n x DESCRIPTOR_SIZE].
+        @param indices The landmark index of each descriptor row.
+        @param slots Number of landmark slots.
+        */
+        void assign(const cv::Mat& descriptors, const std::vector<int>& indices, int slots);
+
+        /** @brief Number of landmark slots.
+        */
+        int slots() const { return (int)m_valid.size(); }
+
+        /** @brief Return true if the landmark has a descriptor.
+        */
+        bool valid(int i) const { return m_valid[i] != 0; }
+
+        const uint8_t* data() const { return m_data.data(); }
+        const uint8_t* validData() const { return m_valid.data(); }
+
+    private:
+        void allocate(int slots);
+
+    private:
+        AlignedArray<uint8_t> m_data;
+        std::vector<uint8_t> m_valid;
+    };
+
+    /** @brief Sum of the Hamming distances of all the landmarks that have a
+    descriptor in both stores.
+    The kernel is selected at runtime by the CPU features: AVX2, POPCNT or a
+    portable fallback.
+    @param a First store.
+    @param b Second store.
+    @param pairs Output number of compared landmarks.
+    @return Total Hamming distance [bits].
+    */
+    int hammingDistance(const DescriptorStore& a, const DescriptorStore& b, int& pairs);
+
+}   // namespace sfl
+
+#endif	// __SFL_HAMMING__
@@ -0,0 +1,24 @@
+#ifndef __SFL_IO_CONVERSION__
+#define __SFL_IO_CONVERSION__
+
+#ifdef WITH_PROTOBUF
+
+// sfl
+#include "sfl/sequence_face_landmarks.h"
+#include "sequence_face_landmarks.pb.h"
+
+namespace sfl
+{
+    /** @brief Convert a frame to protobuf format.
+    */
+    void convert(const Frame& frame, io::Frame& io_frame);
+
+    /** @brief Convert a frame from protobuf format.
+    */
+    void convert(const io::Frame& io_frame, Frame& frame);
+
+}   // namespace sfl
+
+#endif // WITH_PROTOBUF
+
+#endif	// __SFL_IO_CONVERSION__
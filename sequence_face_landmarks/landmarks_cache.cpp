@@ -0,0 +1,307 @@
+#include "sfl/landmarks_cache.h"
+
+// std
+#include <fstream>
+#include <exception>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+// Boost
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+using std::runtime_error;
+namespace bi = boost::interprocess;
+
+namespace sfl
+{
+    const char CACHE_MAGIC[4] = { 'S', 'F', 'L', 'C' };
+    const uint32_t CACHE_VERSION = 1;
+
+    // The file layout is: header, input path, landmark blocks, face table, frame index.
+    // All the records are made of 4 byte fields in native byte order.
+    struct CacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t frame_count;
+        uint32_t face_count;
+        uint32_t landmarks_stride;  // Maximum number of landmarks per face
+        uint32_t input_path_size;
+        uint64_t landmarks_offset;
+        uint64_t faces_offset;
+        uint64_t frames_offset;
+    };
+
+    struct CacheFrame
+    {
+        int32_t id;
+        int32_t width;
+        int32_t height;
+        uint32_t first_face;
+        uint32_t face_count;
+        uint32_t reserved;
+    };
+
+    struct CacheFace
+    {
+        int32_t id;
+        int32_t x;
+        int32_t y;
+        int32_t width;
+        int32_t height;
+        uint32_t landmark_count;
+    };
+
+    static_assert(sizeof(CacheHeader) == 48, "Unexpected cache header size");
+    static_assert(sizeof(CacheFrame) == 24, "Unexpected cache frame size");
+    static_assert(sizeof(CacheFace) == 24, "Unexpected cache face size");
+
+    /** Writes the cache file one frame at a time.
+    Landmarks are written as they come while the face table and the frame index
+    are kept in memory and written at the end. If a face has more landmarks than
+    the landmarks stride, the landmark blocks written so far are rewritten with
+    a larger stride.
+    */
+    class LandmarksCacheWriter
+    {
+    public:
+        LandmarksCacheWriter(const std::string& filePath, const std::string& inputPath,
+            int landmarks_stride) :
+            m_output(filePath, std::fstream::in | std::fstream::out |
+                std::fstream::trunc | std::fstream::binary),
+            m_block(landmarks_stride * 2, 0)
+        {
+            if (!m_output.is_open())
+                throw runtime_error("Failed to open \"" + filePath + "\" for writing!");
+
+            std::memset(&m_header, 0, sizeof(m_header));
+            std::memcpy(m_header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+            m_header.version = CACHE_VERSION;
+            m_header.landmarks_stride = (uint32_t)landmarks_stride;
+            m_header.input_path_size = (uint32_t)inputPath.size();
+
+            // Write placeholder header and input path
+            m_output.write((const char*)&m_header, sizeof(m_header));
+            m_output.write(inputPath.data(), inputPath.size());
+            pad();
+            m_header.landmarks_offset = (uint64_t)m_output.tellp();
+        }
+
+        void write(const Frame& frame)
+        {
+            CacheFrame cache_frame = {};
+            cache_frame.id = frame.id;
+            cache_frame.width = frame.width;
+            cache_frame.height = frame.height;
+            cache_frame.first_face = (uint32_t)m_faces.size();
+            cache_frame.face_count = (uint32_t)frame.faces.size();
+            m_frames.push_back(cache_frame);
+
+            // For each face in the frame
+            for (auto& face : frame.faces)
+            {
+                if (face->landmarks.size() > m_header.landmarks_stride)
+                    restride((uint32_t)face->landmarks.size());
+
+                CacheFace cache_face;
+                cache_face.id = face->id;
+                cache_face.x = face->bbox.x;
+                cache_face.y = face->bbox.y;
+                cache_face.width = face->bbox.width;
+                cache_face.height = face->bbox.height;
+                cache_face.landmark_count = (uint32_t)face->landmarks.size();
+                m_faces.push_back(cache_face);
+
+                // Write landmarks block
+                std::fill(m_block.begin(), m_block.end(), 0);
+                for (size_t i = 0; i < face->landmarks.size(); ++i)
+                {
+                    m_block[2 * i] = face->landmarks[i].x;
+                    m_block[2 * i + 1] = face->landmarks[i].y;
+                }
+                m_output.write((const char*)m_block.data(), m_block.size() * sizeof(int32_t));
+            }
+        }
+
+        void close()
+        {
+            // Write face table and frame index
+            m_header.faces_offset = (uint64_t)m_output.tellp();
+            m_output.write((const char*)m_faces.data(), m_faces.size() * sizeof(CacheFace));
+            m_header.frames_offset = (uint64_t)m_output.tellp();
+            m_output.write((const char*)m_frames.data(), m_frames.size() * sizeof(CacheFrame));
+
+            // Write final header
+            m_header.frame_count = (uint32_t)m_frames.size();
+            m_header.face_count = (uint32_t)m_faces.size();
+            m_output.seekp(0);
+            m_output.write((const char*)&m_header, sizeof(m_header));
+            m_output.close();
+            if (m_output.fail()) throw runtime_error("Failed to write the landmarks cache!");
+        }
+
+    private:
+        /** Increase the landmarks stride, rewriting the landmark blocks of all the
+        faces written so far.
+        */
+        void restride(uint32_t stride)
+        {
+            const uint32_t prev_stride = m_header.landmarks_stride;
+            std::vector<int32_t> landmarks(m_faces.size() * prev_stride * 2);
+            if (!landmarks.empty())
+            {
+                m_output.seekg((std::streamoff)m_header.landmarks_offset);
+                m_output.read((char*)landmarks.data(), landmarks.size() * sizeof(int32_t));
+            }
+
+            m_block.assign(stride * 2, 0);
+            m_output.seekp((std::streamoff)m_header.landmarks_offset);
+            for (size_t j = 0; j < m_faces.size(); ++j)
+            {
+                std::fill(m_block.begin(), m_block.end(), 0);
+                std::copy_n(landmarks.begin() + j * prev_stride * 2, prev_stride * 2,
+                    m_block.begin());
+                m_output.write((const char*)m_block.data(), m_block.size() * sizeof(int32_t));
+            }
+            if (m_output.fail()) throw runtime_error("Failed to write the landmarks cache!");
+            m_header.landmarks_stride = stride;
+        }
+
+        void pad()
+        {
+            const char zeros[8] = {};
+            std::streamoff pos = m_output.tellp();
+            if (pos % 8 != 0) m_output.write(zeros, 8 - pos % 8);
+        }
+
+    private:
+        std::fstream m_output;
+        CacheHeader m_header;
+        std::vector<int32_t> m_block;
+        std::vector<CacheFace> m_faces;
+        std::vector<CacheFrame> m_frames;
+    };
+
+    class LandmarksCacheImpl : public LandmarksCache
+    {
+    public:
+        LandmarksCacheImpl(const std::string& filePath)
+        {
+            try
+            {
+                m_file = bi::file_mapping(filePath.c_str(), bi::read_only);
+                m_region = bi::mapped_region(m_file, bi::read_only);
+            }
+            catch (bi::interprocess_exception& e)
+            {
+                throw runtime_error("Failed to open \"" + filePath + "\": " + e.what());
+            }
+            const char* data = (const char*)m_region.get_address();
+            size_t size = m_region.get_size();
+
+            // Validate header
+            if (size < sizeof(CacheHeader))
+                throw runtime_error("Invalid landmarks cache file!");
+            m_header = (const CacheHeader*)data;
+            if (std::memcmp(m_header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+                m_header->version > CACHE_VERSION ||
+                sizeof(CacheHeader) + m_header->input_path_size > size ||
+                m_header->landmarks_offset + (uint64_t)m_header->face_count *
+                    m_header->landmarks_stride * 2 * sizeof(int32_t) > size ||
+                m_header->faces_offset + (uint64_t)m_header->face_count * sizeof(CacheFace) > size ||
+                m_header->frames_offset + (uint64_t)m_header->frame_count * sizeof(CacheFrame) > size)
+                throw runtime_error("Invalid landmarks cache file!");
+
+            m_input_path.assign(data + sizeof(CacheHeader), m_header->input_path_size);
+            m_landmarks = (const int32_t*)(data + m_header->landmarks_offset);
+            m_faces = (const CacheFace*)(data + m_header->faces_offset);
+            m_frames = (const CacheFrame*)(data + m_header->frames_offset);
+        }
+
+        size_t size() const { return m_header->frame_count; }
+
+        const std::string& getInputPath() const { return m_input_path; }
+
+        void getFrame(size_t i, Frame& frame) const
+        {
+            if (i >= size()) throw runtime_error("Frame position is out of range!");
+            const CacheFrame& cache_frame = m_frames[i];
+            if ((uint64_t)cache_frame.first_face + cache_frame.face_count > m_header->face_count)
+                throw runtime_error("Invalid landmarks cache file!");
+            frame.id = cache_frame.id;
+            frame.width = cache_frame.width;
+            frame.height = cache_frame.height;
+            frame.faces.clear();
+
+            // For each face in the frame
+            for (uint32_t j = 0; j < cache_frame.face_count; ++j)
+            {
+                uint32_t face_ind = cache_frame.first_face + j;
+                const CacheFace& cache_face = m_faces[face_ind];
+                std::unique_ptr<Face> face = std::make_unique<Face>();
+                face->id = cache_face.id;
+                face->bbox = cv::Rect(cache_face.x, cache_face.y, cache_face.width,
+                    cache_face.height);
+
+                // Read landmarks block
+                uint32_t landmark_count = std::min(cache_face.landmark_count,
+                    m_header->landmarks_stride);
+                const int32_t* block = m_landmarks +
+                    (size_t)face_ind * m_header->landmarks_stride * 2;
+                face->landmarks.resize(landmark_count);
+                for (uint32_t k = 0; k < landmark_count; ++k)
+                    face->landmarks[k] = cv::Point(block[2 * k], block[2 * k + 1]);
+
+                frame.faces.push_back(std::move(face));
+            }
+        }
+
+        size_t getFaceCount(size_t i) const
+        {
+            if (i >= size()) throw runtime_error("Frame position is out of range!");
+            return m_frames[i].face_count;
+        }
+
+    private:
+        bi::file_mapping m_file;
+        bi::mapped_region m_region;
+        const CacheHeader* m_header = nullptr;
+        const int32_t* m_landmarks = nullptr;
+        const CacheFace* m_faces = nullptr;
+        const CacheFrame* m_frames = nullptr;
+        std::string m_input_path;
+    };
+
+    std::shared_ptr<LandmarksCache> LandmarksCache::open(const std::string& filePath)
+    {
+        return std::make_shared<LandmarksCacheImpl>(filePath);
+    }
+
+    void LandmarksCache::write(const std::string& filePath,
+        const std::list<std::unique_ptr<Frame>>& sequence, const std::string& inputPath)
+    {
+        // Find the landmarks stride
+        size_t max_landmarks = 0;
+        for (auto& frame : sequence)
+            for (auto& face : frame->faces)
+                max_landmarks = std::max(max_landmarks, face->landmarks.size());
+
+        LandmarksCacheWriter writer(filePath, inputPath, (int)max_landmarks);
+        for (auto& frame : sequence)
+            writer.write(*frame);
+        writer.close();
+    }
+
+    void LandmarksCache::write(const std::string& filePath, SequenceReader& reader)
+    {
+        // The stride is set by the first face and grows if a larger face is read
+        LandmarksCacheWriter writer(filePath, reader.getInputPath(), 0);
+        Frame frame;
+        while (reader.read(frame))
+            writer.write(frame);
+        writer.close();
+    }
+
+}   // namespace sfl
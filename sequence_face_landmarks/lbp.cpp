@@ -0,0 +1,177 @@
+#include "lbp.h"
+
+// std
+#include <cmath>
+#include <limits>
+#include <exception>
+#include <algorithm>
+
+// OpenCV
+#include <opencv2/imgproc.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+using std::runtime_error;
+
+namespace sfl
+{
+    void computeLBPHistogram(const cv::Mat& img, cv::Mat& hist, int radius,
+        int neighbors, int grid_x, int grid_y)
+    {
+        if (img.type() != CV_8UC1)
+            throw runtime_error("LBP histogram requires a grayscale image!");
+        if (neighbors < 1 || neighbors > 16)
+            throw runtime_error("LBP neighbors must be in the range [1, 16]!");
+
+        const int bins = 1 << neighbors;
+        const int rows = img.rows - 2 * radius, cols = img.cols - 2 * radius;
+        hist.create(1, grid_x * grid_y * bins, CV_32F);
+        hist.setTo(0);
+        if (rows <= 0 || cols <= 0) return;
+        const int cell_width = cols / grid_x, cell_height = rows / grid_y;
+        if (cell_width == 0 || cell_height == 0) return;
+
+        // Sample point offsets and bilinear interpolation weights
+        const double pi = 3.14159265358979323846;
+        std::vector<int> fx(neighbors), fy(neighbors), cx(neighbors), cy(neighbors);
+        std::vector<float> w1(neighbors), w2(neighbors), w3(neighbors), w4(neighbors);
+        for (int n = 0; n < neighbors; ++n)
+        {
+            float x = (float)(radius * std::cos(2.0 * pi * n / neighbors));
+            float y = (float)(-radius * std::sin(2.0 * pi * n / neighbors));
+            fx[n] = (int)std::floor(x);
+            fy[n] = (int)std::floor(y);
+            cx[n] = (int)std::ceil(x);
+            cy[n] = (int)std::ceil(y);
+            float tx = x - fx[n], ty = y - fy[n];
+            w1[n] = (1 - tx) * (1 - ty);
+            w2[n] = tx * (1 - ty);
+            w3[n] = (1 - tx) * ty;
+            w4[n] = tx * ty;
+        }
+
+        // Only the pixels covered by the grid are counted
+        cv::Mat_<int> counts = cv::Mat_<int>::zeros(1, hist.cols);
+        int* counts_data = counts[0];
+        const float eps = std::numeric_limits<float>::epsilon();
+        for (int i = 0; i < cell_height * grid_y; ++i)
+        {
+            const int y = i + radius;
+            int* cell_row = counts_data + (i / cell_height) * grid_x * bins;
+            for (int j = 0; j < cell_width * grid_x; ++j)
+            {
+                const int x = j + radius;
+                const float center = img.at<uchar>(y, x);
+                int code = 0;
+                for (int n = 0; n < neighbors; ++n)
+                {
+                    float t = w1[n] * img.at<uchar>(y + fy[n], x + fx[n]) +
+                        w2[n] * img.at<uchar>(y + fy[n], x + cx[n]) +
+                        w3[n] * img.at<uchar>(y + cy[n], x + fx[n]) +
+                        w4[n] * img.at<uchar>(y + cy[n], x + cx[n]);
+                    code |= ((t > center) || (std::abs(t - center) < eps)) << n;
+                }
+                ++cell_row[(j / cell_width) * bins + code];
+            }
+        }
+
+        // Normalize each cell's histogram by the cell's number of pixels
+        counts.convertTo(hist, CV_32F, 1.0 / (cell_width * cell_height));
+    }
+
+    /** Chi-square distance of a block of bins, vectorized when SIMD is available.
+    */
+    static double chiSquareBlock(const float* hist1, const float* hist2, int size)
+    {
+        const float eps = std::numeric_limits<float>::epsilon();
+        int i = 0;
+        double dist = 0;
+#if CV_SIMD128
+        cv::v_float32x4 sum = cv::v_setzero_f32();
+        const cv::v_float32x4 v_eps = cv::v_setall_f32(eps), v_one = cv::v_setall_f32(1.0f);
+        for (; i <= size - 4; i += 4)
+        {
+            cv::v_float32x4 h1 = cv::v_load(hist1 + i), h2 = cv::v_load(hist2 + i);
+            cv::v_float32x4 a = h1 - h2, b = h1 + h2;
+            cv::v_float32x4 mask = b > v_eps;
+            cv::v_float32x4 t = a * a / cv::v_select(mask, b, v_one);
+            sum += cv::v_select(mask, t, cv::v_setzero_f32());
+        }
+        dist = 2.0 * cv::v_reduce_sum(sum);
+#endif
+        for (; i < size; ++i)
+        {
+            float a = hist1[i] - hist2[i];
+            float b = hist1[i] + hist2[i];
+            if (b > eps) dist += 2.0 * a * a / b;
+        }
+        return dist;
+    }
+
+    double chiSquareDistance(const float* hist1, const float* hist2, int size)
+    {
+        double dist = 0;
+        chiSquareDistances(&hist1, 1, &hist2, 1, size, &dist);
+        return dist;
+    }
+
+    void chiSquareDistances(const float* const* hists1, int n1,
+        const float* const* hists2, int n2, int size, double* dists)
+    {
+        // 4KB blocks, a block of all the histograms of the second set fits in L2
+        const int block_size = 1024;
+        std::fill(dists, dists + n1 * n2, 0.0);
+        for (int k = 0; k < size; k += block_size)
+        {
+            int len = std::min(block_size, size - k);
+            double* d = dists;
+            for (int i = 0; i < n1; ++i)
+                for (int j = 0; j < n2; ++j)
+                    *d++ += chiSquareBlock(hists1[i] + k, hists2[j] + k, len);
+        }
+    }
+
+    int HistogramStore::add(const cv::Mat& hist)
+    {
+        if (hist.type() != CV_32F || (int)hist.total() != m_size)
+            throw runtime_error("Histogram size doesn't match the store!");
+
+        int index;
+        if (!m_free.empty())
+        {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            // Grow by doubling the capacity
+            if (m_rows == m_data.rows)
+            {
+                cv::Mat data(std::max(2 * m_data.rows, 8), m_size, CV_32F);
+                if (m_rows > 0) m_data.copyTo(data.rowRange(0, m_rows));
+                m_data = data;
+            }
+            index = m_rows++;
+        }
+        hist.reshape(1, 1).copyTo(m_data.row(index));
+        return index;
+    }
+
+    void HistogramStore::remove(int index)
+    {
+        if (index >= 0 && index < m_rows) m_free.push_back(index);
+    }
+
+    void HistogramStore::clear()
+    {
+        m_rows = 0;
+        m_free.clear();
+    }
+
+    HistogramStore HistogramStore::clone() const
+    {
+        HistogramStore store(*this);
+        store.m_data = m_data.clone();
+        return store;
+    }
+
+}   // namespace sfl
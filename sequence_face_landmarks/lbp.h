@@ -0,0 +1,85 @@
+#ifndef __SFL_LBP__
+#define __SFL_LBP__
+
+// std
+#include <vector>
+
+// OpenCV
+#include <opencv2/core.hpp>
+
+namespace sfl
+{
+    /** @brief Compute the spatial histogram of extended local binary patterns.
+    Matches the histograms of OpenCV's LBPHFaceRecognizer: circular patterns with
+    bilinear interpolation, one normalized 2^neighbors bins histogram per grid cell,
+    concatenated into a single row.
+    @param img Grayscale image [CV_8UC1].
+    @param hist Output histogram [CV_32FC1, 1 x grid_x * grid_y * 2^neighbors]. If hist
+    already has this size and type, e.g. a row of a larger matrix, it is written in place.
+    @param radius Pattern radius.
+    @param neighbors Number of pattern sample points [1, 16].
+    @param grid_x Number of grid cells in the horizontal direction.
+    @param grid_y Number of grid cells in the vertical direction.
+    */
+    void computeLBPHistogram(const cv::Mat& img, cv::Mat& hist, int radius = 3,
+        int neighbors = 8, int grid_x = 8, int grid_y = 8);
+
+    /** @brief Chi-square distance between two non-negative histograms.
+    Same as cv::compareHist with HISTCMP_CHISQR_ALT.
+    */
+    double chiSquareDistance(const float* hist1, const float* hist2, int size);
+
+    /** @brief Chi-square distances between all pairs of two sets of histograms.
+    The histograms are compared block by block, so each block of the second set
+    stays in cache while it is compared with all the histograms of the first set.
+    @param hists1 Pointers to the first set of histograms.
+    @param n1 Number of histograms in the first set.
+    @param hists2 Pointers to the second set of histograms.
+    @param n2 Number of histograms in the second set.
+    @param size Number of bins in each histogram.
+    @param dists Output n1 x n2 row major distance matrix.
+    */
+    void chiSquareDistances(const float* const* hists1, int n1,
+        const float* const* hists2, int n2, int size, double* dists);
+
+    /** @brief Fixed length histograms stored as the rows of a single matrix.
+    Removed rows are reused, so the indices of the stored histograms are stable.
+    */
+    class HistogramStore
+    {
+    public:
+        explicit HistogramStore(int size) : m_size(size) {}
+
+        /** @brief Add a histogram and return its index.
+        */
+        int add(const cv::Mat& hist);
+
+        /** @brief Remove the histogram at index.
+        */
+        void remove(int index);
+
+        /** @brief Remove all histograms.
+        */
+        void clear();
+
+        /** @brief Histogram length.
+        */
+        int size() const { return m_size; }
+
+        float* get(int index) { return m_data.ptr<float>(index); }
+        const float* get(int index) const { return m_data.ptr<float>(index); }
+
+        /** @brief Create a full copy.
+        */
+        HistogramStore clone() const;
+
+    private:
+        int m_size;
+        int m_rows = 0;
+        cv::Mat m_data;
+        std::vector<int> m_free;
+    };
+
+}   // namespace sfl
+
+#endif	// __SFL_LBP__
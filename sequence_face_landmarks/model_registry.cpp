@@ -0,0 +1,93 @@
+#include "model_registry.h"
+
+// std
+#include <map>
+#include <mutex>
+#include <future>
+#include <ctime>
+
+// Boost
+#include <boost/filesystem.hpp>
+
+using namespace boost::filesystem;
+
+namespace sfl
+{
+    std::shared_ptr<const FaceModel> getFaceModel(const std::string& modelPath)
+    {
+        typedef std::pair<std::string, std::time_t> ModelKey;
+        typedef std::shared_future<std::shared_ptr<const FaceModel>> ModelFuture;
+        struct ModelEntry
+        {
+            ModelFuture loading;                    ///< Valid while the model is loading
+            std::weak_ptr<const FaceModel> model;   ///< The model once it is loaded
+        };
+        static std::map<ModelKey, ModelEntry> models;
+        static std::mutex models_mutex;
+
+        // The same file may be referenced by different paths
+        path model_path = canonical(modelPath);
+        ModelKey key(model_path.string(), last_write_time(model_path));
+
+        ModelFuture loading;
+        std::promise<std::shared_ptr<const FaceModel>> promise;
+        {
+            std::lock_guard<std::mutex> lock(models_mutex);
+
+            // Remove models that are no longer in use
+            for (auto it = models.begin(); it != models.end();)
+            {
+                if (!it->second.loading.valid() && it->second.model.expired())
+                    it = models.erase(it);
+                else ++it;
+            }
+
+            // Look for an already loaded or loading model
+            auto it = models.find(key);
+            if (it != models.end() && it->second.loading.valid())
+                loading = it->second.loading;
+            else
+            {
+                if (it != models.end())
+                {
+                    std::shared_ptr<const FaceModel> model = it->second.model.lock();
+                    if (model) return model;
+                }
+                models[key].loading = promise.get_future().share();
+            }
+        }
+
+        // Wait for another thread to load the model, without blocking other models
+        if (loading.valid()) return loading.get();
+
+        // Load model without holding the lock
+        std::shared_ptr<FaceModel> model;
+        try
+        {
+            model = std::make_shared<FaceModel>();
+            model->detector = dlib::get_frontal_face_detector();
+            dlib::deserialize(model_path.string()) >> model->pose_model;
+        }
+        catch (...)
+        {
+            {
+                std::lock_guard<std::mutex> lock(models_mutex);
+                models.erase(key);
+            }
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+
+        // Publish the model, the registry keeps only a weak reference
+        {
+            std::lock_guard<std::mutex> lock(models_mutex);
+            ModelEntry& entry = models[key];
+            entry.loading = ModelFuture();
+            entry.model = model;
+        }
+        promise.set_value(model);
+
+        return model;
+    }
+
+}   // namespace sfl
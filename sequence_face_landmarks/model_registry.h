@@ -0,0 +1,60 @@
+#ifndef __SFL_MODEL_REGISTRY__
+#define __SFL_MODEL_REGISTRY__
+
+// std
+#include <string>
+#include <memory>
+#include <mutex>
+
+// dlib
+#include <dlib/image_processing/frontal_face_detector.h>
+#include <dlib/image_processing/shape_predictor.h>
+
+// sfl
+#include "shape_regressor.h"
+
+namespace sfl
+{
+    /** @brief Face detector and landmarks model loaded from a landmarks model file.
+    The model is immutable and shared by all the instances using the same file.
+    */
+    struct FaceModel
+    {
+        /** Face detector for finding bounding boxes for each face in an image.
+        The detector is not safe for concurrent use, each user should make its own copy.
+        */
+        dlib::frontal_face_detector detector;
+
+        /** Shape predictor for finding landmark positions given an image and face
+        bounding box. Safe for concurrent use.
+        */
+        dlib::shape_predictor pose_model;
+
+        /** Get the shape predictor's cascade, for predicting from an initial estimate
+        or running part of the cascade. It holds its own copy of the forests, so it
+        is created on first use. Safe for concurrent use.
+        */
+        const ShapeRegressor& getRegressor() const
+        {
+            std::call_once(m_regressor_once,
+                [this] { m_regressor = std::make_unique<ShapeRegressor>(pose_model); });
+            return *m_regressor;
+        }
+
+    private:
+        mutable std::once_flag m_regressor_once;
+        mutable std::unique_ptr<const ShapeRegressor> m_regressor;
+    };
+
+    /** @brief Get the model of a landmarks model file.
+    The model is loaded on first use and shared while it is referenced. If the file
+    was modified since it was loaded, it will be loaded again.
+    This function is thread safe. Threads requesting a model that is being loaded
+    wait for it, while other models are loaded concurrently.
+    @param modelPath Path to the landmarks model file.
+    */
+    std::shared_ptr<const FaceModel> getFaceModel(const std::string& modelPath);
+
+}   // namespace sfl
+
+#endif	// __SFL_MODEL_REGISTRY__
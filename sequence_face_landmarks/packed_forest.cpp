@@ -0,0 +1,190 @@
+#include "packed_forest.h"
+
+// std
+#include <stdexcept>
+#include <cmath>
+
+// OpenCV
+#include <opencv2/core.hpp>
+
+#ifdef SFL_X64
+#include <immintrin.h>
+#endif
+
+using std::runtime_error;
+
+namespace sfl
+{
+    PackedForest::PackedForest(const std::vector<dlib::impl::regression_tree>& forest)
+    {
+        if (forest.empty()) return;
+        m_trees = (int)forest.size();
+        m_splits = (int)forest[0].splits.size();
+        m_leaves = m_splits + 1;
+        m_values = forest[0].leaf_values.empty() ? 0 : (int)forest[0].leaf_values[0].size();
+        m_stride = (m_values + 15) / 16 * 16;
+        while ((1 << m_depth) < m_leaves) ++m_depth;
+        if ((1 << m_depth) != m_leaves)
+            throw runtime_error("Regression trees must be complete binary trees!");
+
+        // Quantize the leaf values with the largest magnitude in the forest
+        float max_value = 0;
+        for (const dlib::impl::regression_tree& tree : forest)
+        {
+            if ((int)tree.splits.size() != m_splits || (int)tree.leaf_values.size() != m_leaves)
+                throw runtime_error("Regression trees must have the same depth!");
+            for (const dlib::matrix<float, 0, 1>& values : tree.leaf_values)
+            {
+                if ((int)values.size() != m_values)
+                    throw runtime_error("Regression tree leaves must have the same size!");
+                max_value = std::max(max_value, dlib::max(dlib::abs(values)));
+            }
+        }
+        m_scale = max_value > 0 ? max_value / 32767.0f : 1.0f;
+
+        m_idx1.resize((size_t)m_trees * m_splits);
+        m_idx2.resize((size_t)m_trees * m_splits);
+        m_thresh.resize((size_t)m_trees * m_splits);
+        m_leaf_values.resize((size_t)m_trees * m_leaves * m_stride);
+        for (int t = 0; t < m_trees; ++t)
+        {
+            const dlib::impl::regression_tree& tree = forest[t];
+            for (int i = 0; i < m_splits; ++i)
+            {
+                size_t k = (size_t)t * m_splits + i;
+                m_idx1[k] = (int32_t)tree.splits[i].idx1;
+                m_idx2[k] = (int32_t)tree.splits[i].idx2;
+                m_thresh[k] = tree.splits[i].thresh;
+            }
+            for (int l = 0; l < m_leaves; ++l)
+            {
+                int16_t* leaf = m_leaf_values.data() + ((size_t)t * m_leaves + l) * m_stride;
+                for (int v = 0; v < m_values; ++v)
+                    leaf[v] = (int16_t)std::lround(tree.leaf_values[l](v) / m_scale);
+            }
+        }
+    }
+
+    /** Find the leaf index of each tree.
+    */
+    static void findLeavesScalar(const float* features, const int32_t* idx1,
+        const int32_t* idx2, const float* thresh, int splits, int depth, int trees,
+        int32_t* leaves)
+    {
+        for (int t = 0; t < trees; ++t)
+        {
+            const size_t base = (size_t)t * splits;
+            int i = 0;
+            for (int d = 0; d < depth; ++d)
+            {
+                if (features[idx1[base + i]] - features[idx2[base + i]] > thresh[base + i])
+                    i = 2 * i + 1;
+                else
+                    i = 2 * i + 2;
+            }
+            leaves[t] = i - splits;
+        }
+    }
+
+    static void accumulateLeavesScalar(const int16_t* leaf_values, const int32_t* leaves,
+        int trees, int leaves_per_tree, int stride, int32_t* acc)
+    {
+        for (int t = 0; t < trees; ++t)
+        {
+            const int16_t* leaf = leaf_values + ((size_t)t * leaves_per_tree + leaves[t]) * stride;
+            for (int v = 0; v < stride; ++v)
+                acc[v] += leaf[v];
+        }
+    }
+
+#ifdef SFL_X64
+    /** Find the leaf index of each tree, descending 8 trees at once.
+    */
+    SFL_TARGET("avx2")
+    static void findLeavesAVX2(const float* features, const int32_t* idx1,
+        const int32_t* idx2, const float* thresh, int splits, int depth, int trees,
+        int32_t* leaves)
+    {
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i splits_v = _mm256_set1_epi32(splits);
+        const __m256i two = _mm256_set1_epi32(2);
+        int t = 0;
+        for (; t + 8 <= trees; t += 8)
+        {
+            __m256i base = _mm256_mullo_epi32(
+                _mm256_add_epi32(_mm256_set1_epi32(t), lanes), splits_v);
+            __m256i node = _mm256_setzero_si256();
+            for (int d = 0; d < depth; ++d)
+            {
+                __m256i k = _mm256_add_epi32(base, node);
+                __m256i i1 = _mm256_i32gather_epi32((const int*)idx1, k, 4);
+                __m256i i2 = _mm256_i32gather_epi32((const int*)idx2, k, 4);
+                __m256 th = _mm256_i32gather_ps(thresh, k, 4);
+                __m256 diff = _mm256_sub_ps(_mm256_i32gather_ps(features, i1, 4),
+                    _mm256_i32gather_ps(features, i2, 4));
+
+                // Left child is 2 * i + 1, right child is 2 * i + 2, the mask is -1 for left
+                __m256i left = _mm256_castps_si256(_mm256_cmp_ps(diff, th, _CMP_GT_OQ));
+                node = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(node, node), two), left);
+            }
+            _mm256_storeu_si256((__m256i*)(leaves + t), _mm256_sub_epi32(node, splits_v));
+        }
+        findLeavesScalar(features, idx1 + (size_t)t * splits, idx2 + (size_t)t * splits,
+            thresh + (size_t)t * splits, splits, depth, trees - t, leaves + t);
+    }
+
+    SFL_TARGET("avx2")
+    static void accumulateLeavesAVX2(const int16_t* leaf_values, const int32_t* leaves,
+        int trees, int leaves_per_tree, int stride, int32_t* acc)
+    {
+        for (int t = 0; t < trees; ++t)
+        {
+            const int16_t* leaf = leaf_values + ((size_t)t * leaves_per_tree + leaves[t]) * stride;
+            for (int v = 0; v < stride; v += 8)
+            {
+                __m256i values = _mm256_cvtepi16_epi32(_mm_load_si128((const __m128i*)(leaf + v)));
+                __m256i sum = _mm256_add_epi32(_mm256_load_si256((const __m256i*)(acc + v)), values);
+                _mm256_store_si256((__m256i*)(acc + v), sum);
+            }
+        }
+    }
+#endif
+
+    struct ForestKernels
+    {
+        void(*findLeaves)(const float*, const int32_t*, const int32_t*, const float*,
+            int, int, int, int32_t*);
+        void(*accumulateLeaves)(const int16_t*, const int32_t*, int, int, int, int32_t*);
+    };
+
+    static ForestKernels selectForestKernels()
+    {
+#ifdef SFL_X64
+        if (cv::checkHardwareSupport(CV_CPU_AVX2))
+            return { findLeavesAVX2, accumulateLeavesAVX2 };
+#endif
+        return { findLeavesScalar, accumulateLeavesScalar };
+    }
+
+    void PackedForest::evaluate(const float* features, unsigned long trees, float* shape) const
+    {
+        static const ForestKernels kernels = selectForestKernels();
+        int n = trees > 0 ? (int)std::min(trees, (unsigned long)m_trees) : m_trees;
+        if (n == 0) return;
+
+        // Scratch buffers are kept per thread
+        thread_local std::vector<int32_t> leaves;
+        thread_local AlignedArray<int32_t> acc;
+        leaves.resize(n);
+        if (acc.size() != (size_t)m_stride) acc.resize(m_stride);
+        else std::fill(acc.data(), acc.data() + m_stride, 0);
+
+        kernels.findLeaves(features, m_idx1.data(), m_idx2.data(), m_thresh.data(),
+            m_splits, m_depth, n, leaves.data());
+        kernels.accumulateLeaves(m_leaf_values.data(), leaves.data(), n, m_leaves,
+            m_stride, acc.data());
+        for (int v = 0; v < m_values; ++v)
+            shape[v] += acc[v] * m_scale;
+    }
+
+}   // namespace sfl
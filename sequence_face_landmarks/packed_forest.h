@@ -0,0 +1,60 @@
+#ifndef __SFL_PACKED_FOREST__
+#define __SFL_PACKED_FOREST__
+
+// std
+#include <vector>
+#include <cstdint>
+
+// dlib
+#include <dlib/image_processing/shape_predictor.h>
+
+// sfl
+#include "simd.h"
+
+namespace sfl
+{
+    /** @brief Regression forest of a shape predictor cascade stage in a packed layout.
+    The split features, thresholds and leaf values of all the trees are stored in
+    contiguous cache line aligned arrays, tree after tree. The leaf values are
+    quantized to 16 bits with a single scale per forest. The trees are evaluated
+    several at a time with SIMD gathers when the CPU supports AVX2.
+    */
+    class PackedForest
+    {
+    public:
+        PackedForest() {}
+
+        /** @brief Pack a forest.
+        All the trees must be complete binary trees of the same depth.
+        @throw std::runtime_error if the forest can't be packed.
+        */
+        explicit PackedForest(const std::vector<dlib::impl::regression_tree>& forest);
+
+        /** @brief Number of trees.
+        */
+        int trees() const { return m_trees; }
+
+        /** @brief Add the leaf values of the first trees to the shape.
+        @param features Feature pixel values.
+        @param trees Number of trees to evaluate. If zero, all the trees are evaluated.
+        @param shape The shape to add to [2 * landmarks].
+        */
+        void evaluate(const float* features, unsigned long trees, float* shape) const;
+
+    private:
+        int m_trees = 0;
+        int m_depth = 0;
+        int m_splits = 0;       ///< Splits per tree.
+        int m_leaves = 0;       ///< Leaves per tree.
+        int m_values = 0;       ///< Values per leaf.
+        int m_stride = 0;       ///< Values per leaf padded to a multiple of 16.
+        float m_scale = 1.0f;   ///< Leaf values quantization step.
+        AlignedArray<int32_t> m_idx1;
+        AlignedArray<int32_t> m_idx2;
+        AlignedArray<float> m_thresh;
+        AlignedArray<int16_t> m_leaf_values;
+    };
+
+}   // namespace sfl
+
+#endif	// __SFL_PACKED_FOREST__
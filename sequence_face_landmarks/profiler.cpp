@@ -0,0 +1,97 @@
+#include "sfl/profiler.h"
+
+// std
+#include <algorithm>
+#include <iomanip>
+
+namespace sfl
+{
+    void Profiler::add(ProfileStage stage, double ms)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_current[stage] += ms;
+        ++m_stats[stage].calls;
+    }
+
+    void Profiler::endFrame()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int i = 0; i < PROFILE_STAGE_COUNT; ++i)
+        {
+            ProfileStat& stat = m_stats[i];
+            stat.frame = m_current[i];
+            stat.total += m_current[i];
+            stat.max_frame = std::max(stat.max_frame, m_current[i]);
+            m_current[i] = 0;
+        }
+        ++m_frame_count;
+    }
+
+    void Profiler::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int i = 0; i < PROFILE_STAGE_COUNT; ++i)
+        {
+            m_stats[i] = ProfileStat();
+            m_current[i] = 0;
+        }
+        m_frame_count = 0;
+    }
+
+    ProfileStat Profiler::getStat(ProfileStage stage) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats[stage];
+    }
+
+    size_t Profiler::getFrameCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_frame_count;
+    }
+
+    void Profiler::print(std::ostream& out) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ios_base::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+
+        out << "Frames: " << m_frame_count << std::endl;
+        out << std::left << std::setw(20) << "Stage" << std::right <<
+            std::setw(12) << "Total [ms]" << std::setw(12) << "Avg [ms]" <<
+            std::setw(12) << "Max [ms]" << std::setw(10) << "Calls" << std::endl;
+        out << std::fixed << std::setprecision(3);
+        for (int i = 0; i < PROFILE_STAGE_COUNT; ++i)
+        {
+            const ProfileStat& stat = m_stats[i];
+            if (stat.calls == 0) continue;
+            double avg = m_frame_count > 0 ? stat.total / m_frame_count : 0.0;
+            out << std::left << std::setw(20) << getStageName((ProfileStage)i) <<
+                std::right << std::setw(12) << stat.total << std::setw(12) << avg <<
+                std::setw(12) << stat.max_frame << std::setw(10) << stat.calls << std::endl;
+        }
+
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    const char* Profiler::getStageName(ProfileStage stage)
+    {
+        switch (stage)
+        {
+        case PROFILE_RESIZE: return "resize";
+        case PROFILE_COLOR_CONVERSION: return "color_conversion";
+        case PROFILE_DETECTION: return "detection";
+        case PROFILE_SHAPE_PREDICTION: return "shape_prediction";
+        case PROFILE_TRACKING: return "tracking";
+        case PROFILE_BRISK_DETECT: return "brisk_detect";
+        case PROFILE_BRISK_COMPUTE: return "brisk_compute";
+        case PROFILE_BRISK_MATCH: return "brisk_match";
+        case PROFILE_LBP_PREDICT: return "lbp_predict";
+        case PROFILE_LBP_UPDATE: return "lbp_update";
+        case PROFILE_OPTICAL_FLOW: return "optical_flow";
+        default: return "unknown";
+        }
+    }
+
+}   // namespace sfl
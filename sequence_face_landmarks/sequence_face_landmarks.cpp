@@ -1,18 +1,26 @@
 #include "sfl/sequence_face_landmarks.h"
 #include "sfl/face_tracker.h"
-
-#ifdef WITH_PROTOBUF
-#include "sequence_face_landmarks.pb.h"
-#endif // WITH_PROTOBUF
+#include "sfl/sequence_io.h"
+#include "sfl/flat_sequence.h"
+#include "sfl/profiler.h"
+#include "sfl/frame_context.h"
+#include "sfl/thread_pool.h"
+#include "model_registry.h"
+#include "io_conversion.h"
 
 // std
 #include <exception>
+#include <fstream>
+#include <deque>
+#include <thread>
+#include <algorithm>
 
 // Boost
 #include <boost/filesystem.hpp>
 
 // OpenCV
 #include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
 
 // dlib
 #include <dlib/opencv.h>
@@ -26,12 +34,28 @@ using namespace boost::filesystem;
 
 namespace sfl
 {
+    /** Size of the faces found on the first level of dlib's frontal face detector
+    pyramid [pixels].
+    */
+    const float DETECTOR_WINDOW_SIZE = 80.0f;
+
+    /** Face size ratio between consecutive levels of the detector's pyramid,
+    pyramid_down<6> scales each level by 5/6.
+    */
+    const float DETECTOR_PYRAMID_STEP = 6.0f / 5.0f;
+
+    /** Weight of the last frame in the recent average number of faces, used for
+    deciding when to escalate to the adaptive scales.
+    */
+    const float ADAPTIVE_AVERAGE_WEIGHT = 0.1f;
+
 	class SequenceFaceLandmarksImpl : public SequenceFaceLandmarks
 	{
 	public:
 		SequenceFaceLandmarksImpl(const std::string& landmarks_path, float frame_scale,
             FaceTrackingType tracking) :
-			m_frame_scale(frame_scale), m_frame_counter(0), m_tracking(TRACKING_NONE)
+			m_frame_scale(frame_scale), m_frame_counter(0), m_tracking(TRACKING_NONE),
+            m_detection_mode(DETECTION_FULL), m_detection_interval(10), m_threads(0)
 		{
 			path landmarks(landmarks_path);
 			if (landmarks.extension() == ".pb" || landmarks.extension() == ".lms")
@@ -42,7 +66,8 @@ namespace sfl
 		}
 
 		SequenceFaceLandmarksImpl(float frame_scale, FaceTrackingType tracking) :
-			m_frame_scale(frame_scale), m_frame_counter(0), m_tracking(TRACKING_NONE)
+			m_frame_scale(frame_scale), m_frame_counter(0), m_tracking(TRACKING_NONE),
+            m_detection_mode(DETECTION_FULL), m_detection_interval(10), m_threads(0)
 		{
 			setTracking(tracking);
 		}
@@ -50,49 +75,164 @@ namespace sfl
 		SequenceFaceLandmarksImpl(const SequenceFaceLandmarksImpl& sfl) : 
 			m_model_path(sfl.m_model_path), m_frame_scale(sfl.m_frame_scale),
 			m_frame_counter(sfl.m_frame_counter), m_tracking(sfl.m_tracking),
-			m_detector(sfl.m_detector), m_pose_model(sfl.m_pose_model),
-            m_input_path(sfl.m_input_path)
+            m_tracking_max_age(sfl.m_tracking_max_age),
+            m_tracking_max_lost(sfl.m_tracking_max_lost),
+			m_model(sfl.m_model), m_detectors(sfl.m_detectors),
+            m_input_path(sfl.m_input_path), m_detection_mode(sfl.m_detection_mode),
+            m_detection_interval(sfl.m_detection_interval),
+            m_warm_start_cascades(sfl.m_warm_start_cascades),
+            m_flow_refine_cascades(sfl.m_flow_refine_cascades),
+            m_min_face_size(sfl.m_min_face_size), m_max_face_size(sfl.m_max_face_size),
+            m_adaptive_scales(sfl.m_adaptive_scales), m_recent_faces(sfl.m_recent_faces),
+            m_predictor_cascades(sfl.m_predictor_cascades),
+            m_predictor_trees(sfl.m_predictor_trees),
+            m_predictor_engine(sfl.m_predictor_engine),
+            m_detection_requested(sfl.m_detection_requested),
+            m_frames_since_detection(sfl.m_frames_since_detection),
+            m_prev_frame_id(sfl.m_prev_frame_id), m_prev_faces(sfl.m_prev_faces),
+            m_prev_gray(sfl.m_prev_gray.clone()),
+            m_threads(sfl.m_threads)
 		{
-			if (sfl.m_face_tracker) m_face_tracker = sfl.m_face_tracker->clone();
+			if (sfl.m_face_tracker)
+            {
+                m_face_tracker = sfl.m_face_tracker->clone();
+                m_face_tracker->setProfiler(nullptr);
+            }
 		}
 
+        ~SequenceFaceLandmarksImpl()
+        {
+            // Wait for the workers before the data they reference is destroyed
+            discardPending();
+            m_pool = nullptr;
+        }
+
 		const Frame& addFrame(const cv::Mat& frame, int id)
 		{
 			if (m_model_path.empty())
 				throw runtime_error("A landmarks model file is not set!");
 
-			// Set frame id
-			int frame_id = id;
-			if (id < 0) frame_id = m_frame_counter++;
-			else m_frame_counter = id + 1;
-
-			// Extract landmarks by number of channels
-			std::unique_ptr<Frame> sfl_frame = std::make_unique<Frame>();
-			sfl_frame->id = frame_id;
-			sfl_frame->width = frame.cols;
-			sfl_frame->height = frame.rows;
-			if (frame.channels() == 3)  // BGR
-				extract_landmarks<dlib::bgr_pixel>(frame, *sfl_frame);
-			else // grayscale
-				extract_landmarks<unsigned char>(frame, *sfl_frame);
-
-			// Track faces if enabled
-			if (m_tracking != TRACKING_NONE)
-				m_face_tracker->addFrame(frame, *sfl_frame);
-
-			// Save and output current frame
-			m_frames.push_back(std::move(sfl_frame));
-			return *m_frames.back();
+            // Keep the order of previously added asynchronous frames
+            flush();
+
+            // Extract landmarks, in keyframes and ROI modes the faces are found from
+            // the previous frame unless it is time to scan the entire frame
+            FrameContext context(frame, m_frame_scale, m_profiler.get());
+			std::unique_ptr<Frame> sfl_frame = createFrame(frame, nextFrameID(id));
+            const std::vector<Face>* prev_faces = nullptr;
+            bool consecutive = !m_prev_faces.empty() && sfl_frame->id == m_prev_frame_id + 1;
+            if (m_detection_mode != DETECTION_FULL && !m_detection_requested && consecutive &&
+                m_frames_since_detection + 1 < m_detection_interval)
+                prev_faces = &m_prev_faces;
+            const std::vector<Face>* warm_faces =
+                m_warm_start_cascades > 0 && consecutive ? &m_prev_faces : nullptr;
+            if (extract_landmarks(context, *sfl_frame, m_detectors, prev_faces, warm_faces,
+                m_recent_faces))
+            {
+                m_frames_since_detection = 0;
+                m_detection_requested = false;
+            }
+            else ++m_frames_since_detection;
+
+            // Keep the frame for propagating the faces to the next frame
+            if (m_detection_mode == DETECTION_FLOW)
+                context.getScaledGray().copyTo(m_prev_gray);
+
+			// Track faces and save current frame
+            return commit(context, std::move(sfl_frame));
 		}
 
+        void addFrameAsync(const cv::Mat& frame, int id)
+        {
+            if (m_model_path.empty())
+                throw runtime_error("A landmarks model file is not set!");
+
+            // Frames depending on the previous frame are processed in order
+            if (dependsOnPreviousFrame())
+            {
+                addFrame(frame, id);
+                return;
+            }
+            initPool();
+
+            // Limit the number of frames in flight
+            while (m_pending.size() >= 2 * (size_t)m_pool->size())
+                commitPending();
+
+            // Queue landmarks extraction, the frame is copied because the caller
+            // may reuse its buffer before the frame is processed. The frame's context
+            // is used by the worker and then by the commit, never concurrently
+            int frame_id = nextFrameID(id);
+            PendingFrame pending;
+            pending.context = std::make_shared<FrameContext>(frame.clone(), m_frame_scale,
+                m_profiler.get());
+            std::shared_ptr<FrameContext> context = pending.context;
+            pending.result = m_pool->enqueue([this, context, frame_id](int worker)
+            {
+                std::unique_ptr<Frame> sfl_frame = createFrame(context->getFrame(), frame_id);
+                extract_landmarks(*context, *sfl_frame, m_worker_detectors[worker],
+                    nullptr, nullptr);
+                return sfl_frame;
+            });
+            m_pending.push_back(std::move(pending));
+
+            // Commit frames that are already processed
+            while (!m_pending.empty() && m_pending.front().result.wait_for(
+                std::chrono::seconds(0)) == std::future_status::ready)
+                commitPending();
+        }
+
+        void addFrames(const std::vector<cv::Mat>& frames)
+        {
+            for (const cv::Mat& frame : frames)
+                addFrameAsync(frame);
+            flush();
+        }
+
+        void flush()
+        {
+            while (!m_pending.empty())
+                commitPending();
+        }
+
 		const std::list<std::unique_ptr<Frame>>& getSequence() const { return m_frames; }
 
-        std::list<std::unique_ptr<Frame>>& getSequenceMutable() { return m_frames; }
+        std::list<std::unique_ptr<Frame>>& getSequenceMutable()
+        {
+            m_flat_valid = false;
+            return m_frames;
+        }
+
+        const FlatSequence& getFlatSequence() const
+        {
+            if (!m_flat_valid || m_flat.size() > m_frames.size())
+            {
+                m_flat.assign(m_frames);
+                m_flat_valid = true;
+            }
+            else if (m_flat.size() < m_frames.size())
+            {
+                // Append only the frames added since the last update
+                auto it = m_frames.end();
+                std::advance(it, -(std::ptrdiff_t)(m_frames.size() - m_flat.size()));
+                for (; it != m_frames.end(); ++it)
+                    m_flat.append(**it);
+            }
+            return m_flat;
+        }
 
 		void clear()
 		{
+            discardPending();
 			m_frames.clear();
 			m_frame_counter = 0;
+            m_flat.clear();
+            m_prev_faces.clear();
+            m_prev_gray.release();
+            m_prev_frame_id = -1;
+            m_frames_since_detection = 0;
+            m_detection_requested = false;
+            m_recent_faces = 0;
 		}
 
 		std::shared_ptr<SequenceFaceLandmarks> clone()
@@ -104,51 +244,57 @@ namespace sfl
 
 		float getFrameScale() const { return m_frame_scale; }
 
+        int getPredictorCascades() const { return m_predictor_cascades; }
+
+        int getPredictorTrees() const { return m_predictor_trees; }
+
+        ShapePredictorEngine getPredictorEngine() const { return m_predictor_engine; }
+
+        int getThreads() const
+        {
+            if (m_threads > 0) return m_threads;
+            return std::max((int)std::thread::hardware_concurrency(), 1);
+        }
+
+        std::shared_ptr<Profiler> getProfiler() const { return m_profiler; }
+
         const std::string & getInputPath() const { return m_input_path; }
 
         FaceTrackingType getTracking() const { return m_tracking; }
 
+        int getTrackingMaxAge() const { return m_tracking_max_age; }
+
+        int getTrackingMaxLost() const { return m_tracking_max_lost; }
+
+        FaceDetectionMode getDetectionMode() const { return m_detection_mode; }
+
+        int getDetectionInterval() const { return m_detection_interval; }
+
+        int getWarmStartCascades() const { return m_warm_start_cascades; }
+
+        int getFlowRefineCascades() const { return m_flow_refine_cascades; }
+
+        int getMinFaceSize() const { return m_min_face_size; }
+
+        int getMaxFaceSize() const { return m_max_face_size; }
+
+        const std::vector<float>& getAdaptiveScales() const { return m_adaptive_scales; }
+
 #ifdef WITH_PROTOBUF
 		void load(const std::string& filePath)
 		{
 			clear();
 
-			// Read from file
-			io::Sequence sequence;
-			std::ifstream input(filePath, std::ifstream::binary);
-			sequence.ParseFromIstream(&input);
-
-			// Convert format
-            m_input_path = sequence.input_path();
+			// Read from file, both streamed and whole sequence files are supported
+			std::shared_ptr<SequenceReader> reader = SequenceReader::create(filePath);
+            m_input_path = reader->getInputPath();
 
 			// For each frame in the sequence
-			for (const io::Frame& io_frame : sequence.frames())
+			std::unique_ptr<Frame> frame = std::make_unique<Frame>();
+			while (reader->read(*frame))
 			{
-				std::unique_ptr<Frame> frame = std::make_unique<Frame>();
-				frame->id = (int)io_frame.id();
-				frame->width = (int)io_frame.width();
-				frame->height = (int)io_frame.height();
-
-				// For each face detected in the frame
-				for (const io::Face& io_face : io_frame.faces())
-				{
-					std::unique_ptr<Face> face = std::make_unique<Face>();
-					face->id = io_face.id();
-					const io::BoundingBox& io_bbox = io_face.bbox();
-					face->bbox.x = io_bbox.left();
-					face->bbox.y = io_bbox.top();
-					face->bbox.width = io_bbox.width();
-					face->bbox.height = io_bbox.height();
-					face->landmarks.reserve(io_face.landmarks_size());
-
-					// For each landmark point in the face
-					for (const io::Point& io_point : io_face.landmarks())
-						face->landmarks.push_back(cv::Point(io_point.x(), io_point.y()));
-
-					frame->faces.push_back(std::move(face));
-				}
-
 				m_frames.push_back(std::move(frame));
+				frame = std::make_unique<Frame>();
 			}
 		}
 
@@ -160,32 +306,7 @@ namespace sfl
 
 			// For each frame in the sequence
 			for (auto& frame : m_frames)
-			{
-				io::Frame* io_frame = sequence.add_frames();
-				io_frame->set_id((unsigned int)frame->id);
-				io_frame->set_width(frame->width);
-				io_frame->set_height(frame->height);
-
-				// For each face detected in the frame
-				for (auto& face : frame->faces)
-				{
-					io::Face* io_face = io_frame->add_faces();
-					io_face->set_id((unsigned int)face->id);
-					io::BoundingBox* io_bbox = io_face->mutable_bbox();
-					io_bbox->set_left(face->bbox.x);
-					io_bbox->set_top(face->bbox.y);
-					io_bbox->set_width(face->bbox.width);
-					io_bbox->set_height(face->bbox.height);
-
-					// For each landmark point in the face
-					for (const cv::Point& point : face->landmarks)
-					{
-						io::Point* io_point = io_face->add_landmarks();
-						io_point->set_x(point.x);
-						io_point->set_y(point.y);
-					}
-				}
-			}
+				convert(*frame, *sequence.add_frames());
 
 			// Write to file
 			std::ofstream output(filePath, std::fstream::trunc | std::fstream::binary);
@@ -198,67 +319,489 @@ namespace sfl
 		void save(const std::string& filePath) const { throw runtime_error(NO_PROTOBUF_ERROR); }
 #endif // WITH_PROTOBUF
 
-		void setFrameScale(float frame_scale) { m_frame_scale = frame_scale; }
+        void setPredictorCascades(int cascades)
+        {
+            flush();
+            m_predictor_cascades = std::max(cascades, 0);
+        }
+
+        void setPredictorTrees(int trees)
+        {
+            flush();
+            m_predictor_trees = std::max(trees, 0);
+        }
+
+        void setPredictorEngine(ShapePredictorEngine engine)
+        {
+            flush();
+            m_predictor_engine = engine;
+
+            // Pack the model's forests now rather than while processing the first frame
+            if (m_predictor_engine == PREDICTOR_PACKED && m_model)
+                m_model->getRegressor().isPacked();
+        }
+
+		void setFrameScale(float frame_scale)
+        {
+            flush();
+            m_frame_scale = frame_scale;
+            configure_detector();
+        }
 
 		void setModel(const std::string& modelPath)
 		{
 			if (modelPath.empty()) return;
+            flush();
+            m_pool = nullptr;
 			m_model_path = modelPath;
 
-			// Face detector for finding bounding boxes for each face in an image
-			m_detector = dlib::get_frontal_face_detector();
-
-			// Shape predictor for finding landmark positions given an image and face bounding box.
-			dlib::deserialize(modelPath) >> m_pose_model;
+            // The model is shared with all the instances using the same file
+            m_model = getFaceModel(modelPath);
+            configure_detector();
 		}
 
         void setInputPath(const std::string& inputPath) { m_input_path = inputPath; }
 
+        void setProfiler(std::shared_ptr<Profiler> profiler)
+        {
+            flush();
+            m_profiler = profiler;
+            if (m_face_tracker) m_face_tracker->setProfiler(profiler);
+        }
+
+        void setFrameSink(FrameSink sink)
+        {
+            flush();
+            m_sink = sink;
+        }
+
+        void setDetectionMode(FaceDetectionMode mode)
+        {
+            if (m_detection_mode == mode) return;
+            flush();
+            m_detection_mode = mode;
+            m_prev_faces.clear();
+            m_prev_gray.release();
+        }
+
+        void setDetectionInterval(int interval)
+        {
+            m_detection_interval = std::max(interval, 1);
+        }
+
+        void requestDetection() { m_detection_requested = true; }
+
+        void setWarmStartCascades(int cascades)
+        {
+            if (m_warm_start_cascades == std::max(cascades, 0)) return;
+            flush();
+            m_warm_start_cascades = std::max(cascades, 0);
+        }
+
+        void setFlowRefineCascades(int cascades)
+        {
+            if (m_flow_refine_cascades == std::max(cascades, 1)) return;
+            flush();
+            m_flow_refine_cascades = std::max(cascades, 1);
+        }
+
+        void setMinFaceSize(int size)
+        {
+            flush();
+            m_min_face_size = std::max(size, 0);
+            configure_detector();
+        }
+
+        void setMaxFaceSize(int size)
+        {
+            flush();
+            m_max_face_size = std::max(size, 0);
+            configure_detector();
+        }
+
+        void setAdaptiveScales(const std::vector<float>& scales)
+        {
+            flush();
+            m_adaptive_scales = scales;
+            std::sort(m_adaptive_scales.begin(), m_adaptive_scales.end());
+            configure_detector();
+        }
+
+        void setThreads(int threads)
+        {
+            if (m_threads == threads) return;
+            flush();
+            m_pool = nullptr;
+            m_threads = threads;
+        }
+
 		void setTracking(FaceTrackingType tracking)
 		{
             if (m_tracking == tracking) return;
+            flush();
             m_tracking = tracking;
             if (m_tracking == TRACKING_BRISK)
                 m_face_tracker = createFaceTrackerBRISK();
             else if (m_tracking == TRACKING_LBP)
                 m_face_tracker = createFaceTrackerLBP();
+            else if (m_tracking == TRACKING_MOTION)
+                m_face_tracker = createFaceTrackerMotion();
             else
                 m_face_tracker = nullptr;
+            if (m_face_tracker)
+            {
+                m_face_tracker->setMaxAge(m_tracking_max_age);
+                m_face_tracker->setMaxLost(m_tracking_max_lost);
+                m_face_tracker->setProfiler(m_profiler);
+            }
 		}
 
+        void setTrackingMaxAge(int frames)
+        {
+            flush();
+            m_tracking_max_age = frames;
+            if (m_face_tracker) m_face_tracker->setMaxAge(frames);
+        }
+
+        void setTrackingMaxLost(int faces)
+        {
+            flush();
+            m_tracking_max_lost = faces;
+            if (m_face_tracker) m_face_tracker->setMaxLost(faces);
+        }
+
 		size_t size() const { return m_frames.size(); }
 
 	private:
+        struct PendingFrame
+        {
+            std::shared_ptr<FrameContext> context;
+            std::future<std::unique_ptr<Frame>> result;
+        };
+
+        /** Face detectors configured for the frame scale and the adaptive scales.
+        */
+        struct FaceDetectors
+        {
+            dlib::frontal_face_detector detector;                   ///< Detector at the frame scale
+            std::vector<dlib::frontal_face_detector> escalation;    ///< Detector of each adaptive scale
+            std::vector<float> escalation_scales;                   ///< Adaptive scales larger than the frame scale
+        };
+
+        int nextFrameID(int id)
+        {
+            if (id < 0) return m_frame_counter++;
+            m_frame_counter = id + 1;
+            return id;
+        }
+
+        /** Return true if processing a frame requires the previous frame's faces,
+        or the average number of faces of the frames before it.
+        */
+        bool dependsOnPreviousFrame() const
+        {
+            return m_detection_mode != DETECTION_FULL || m_warm_start_cascades > 0 ||
+                !m_adaptive_scales.empty();
+        }
+
+        static std::unique_ptr<Frame> createFrame(const cv::Mat& frame, int frame_id)
+        {
+            std::unique_ptr<Frame> sfl_frame = std::make_unique<Frame>();
+            sfl_frame->id = frame_id;
+            sfl_frame->width = frame.cols;
+            sfl_frame->height = frame.rows;
+            return sfl_frame;
+        }
+
+        const Frame& commit(FrameContext& context, std::unique_ptr<Frame> sfl_frame)
+        {
+            // Track faces if enabled
+            if (m_tracking != TRACKING_NONE)
+                m_face_tracker->addFrame(context, *sfl_frame);
+
+            // Keep the faces for finding them in the next frame
+            m_prev_frame_id = sfl_frame->id;
+            m_recent_faces += ADAPTIVE_AVERAGE_WEIGHT *
+                ((float)sfl_frame->faces.size() - m_recent_faces);
+            if (dependsOnPreviousFrame())
+            {
+                m_prev_faces.clear();
+                m_prev_faces.reserve(sfl_frame->faces.size());
+                for (auto& face : sfl_frame->faces)
+                    m_prev_faces.push_back(*face);
+            }
+
+            if (m_profiler) m_profiler->endFrame();
+
+            // Save and output current frame
+            m_frames.push_back(std::move(sfl_frame));
+            if (m_sink)
+            {
+                // Stream the frame and release the previous frames
+                m_sink(*m_frames.back());
+                while (m_frames.size() > 1) m_frames.pop_front();
+                m_flat_valid = false;
+            }
+            return *m_frames.back();
+        }
+
+        void commitPending()
+        {
+            PendingFrame pending = std::move(m_pending.front());
+            m_pending.pop_front();
+            commit(*pending.context, pending.result.get());
+        }
+
+        void discardPending()
+        {
+            for (PendingFrame& pending : m_pending)
+                pending.result.wait();
+            m_pending.clear();
+        }
+
+        void initPool()
+        {
+            if (m_pool) return;
+
+            // The face detector is not safe for concurrent use so each worker gets
+            // its own copy, the shape predictor is shared
+            m_pool = std::make_unique<ThreadPool>(getThreads());
+            m_worker_detectors.assign(m_pool->size(), m_detectors);
+        }
+
+        /** Get the scale of the images the face detector runs on, relative to the
+        scaled frame. Below 1 when the minimum face size is larger than the
+        detector's window, with one pyramid level of margin.
+        */
+        float detection_scale() const
+        {
+            if (m_min_face_size <= 0) return 1.0f;
+            return std::min(DETECTOR_WINDOW_SIZE * DETECTOR_PYRAMID_STEP /
+                (m_min_face_size * m_frame_scale), 1.0f);
+        }
+
+        /** Get the number of pyramid levels needed for finding faces up to the
+        specified size in the images the detector runs on, with one level of margin.
+        */
+        static unsigned long pyramid_levels(float max_size)
+        {
+            unsigned long levels = 2;
+            for (float size = DETECTOR_WINDOW_SIZE; size < max_size; size *= DETECTOR_PYRAMID_STEP)
+                ++levels;
+            return levels;
+        }
+
+        /** Create a copy of the model's face detector scanning only the first
+        pyramid levels.
+        */
+        dlib::frontal_face_detector create_detector(unsigned long levels) const
+        {
+            const dlib::frontal_face_detector& detector = m_model->detector;
+            dlib::frontal_face_detector::image_scanner_type scanner;
+            scanner.copy_configuration(detector.get_scanner());
+            scanner.set_max_pyramid_levels(levels);
+            std::vector<dlib::frontal_face_detector::feature_vector_type> w(detector.num_detectors());
+            for (unsigned long i = 0; i < w.size(); ++i)
+                w[i] = detector.get_w(i);
+            return dlib::frontal_face_detector(scanner, detector.get_overlap_tester(), w);
+        }
+
+        /** Set the face detectors' pyramid levels according to the maximum face size
+        and the adaptive scales.
+        */
+        void configure_detector()
+        {
+            if (!m_model) return;
+
+            // The detectors of the workers are copies of these detectors
+            m_pool = nullptr;
+            float base_scale = m_frame_scale * detection_scale();
+            m_detectors.detector = m_max_face_size > 0 ?
+                create_detector(pyramid_levels(m_max_face_size * base_scale)) : m_model->detector;
+
+            // Each adaptive scale only scans the levels of the faces that are too
+            // small for the previous scale
+            m_detectors.escalation.clear();
+            m_detectors.escalation_scales.clear();
+            float prev_scale = base_scale;
+            for (float scale : m_adaptive_scales)
+            {
+                if (scale <= prev_scale) continue;
+                float max_size = DETECTOR_WINDOW_SIZE * scale / prev_scale;
+                if (m_max_face_size > 0) max_size = std::min(max_size, m_max_face_size * scale);
+                m_detectors.escalation.push_back(create_detector(pyramid_levels(max_size)));
+                m_detectors.escalation_scales.push_back(scale);
+                prev_scale = scale;
+            }
+        }
+
+        /** Detect faces in an image of the scaled frame.
+        The image is downscaled by detection_scale before running the detector and
+        the faces are returned in the image's coordinates. Only the detector itself
+        is timed as detection, the downscaling is timed as resizing.
+        */
+        template<typename pixel_type>
+        std::vector<dlib::rectangle> detect_faces(const cv::Mat& img,
+            dlib::frontal_face_detector& detector) const
+        {
+            float scale = detection_scale();
+            if (scale >= 1.0f)
+            {
+                Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_DETECTION);
+                return detector(dlib::cv_image<pixel_type>(img));
+            }
+
+            cv::Mat img_small;
+            {
+                Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_RESIZE);
+                cv::resize(img, img_small, cv::Size(), scale, scale, cv::INTER_AREA);
+            }
+            Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_DETECTION);
+            std::vector<dlib::rectangle> faces = detector(dlib::cv_image<pixel_type>(img_small));
+            timer.stop();
+            for (dlib::rectangle& face : faces)
+            {
+                face = dlib::rectangle(
+                    (long)std::round(face.left() / scale), (long)std::round(face.top() / scale),
+                    (long)std::round(face.right() / scale), (long)std::round(face.bottom() / scale));
+            }
+            return faces;
+        }
+
+        /** Detect faces in the original frame at the adaptive scales, in increasing
+        order, until at least the expected number of faces is found.
+        The faces that don't overlap the already found faces are added in the
+        scaled frame's coordinates.
+        */
+        template<typename pixel_type>
+        void escalate_detection(const cv::Mat& frame, FaceDetectors& detectors,
+            float expected_faces, std::vector<dlib::rectangle>& faces) const
+        {
+            const dlib::test_box_overlap overlaps;
+            for (size_t i = 0; i < detectors.escalation.size(); ++i)
+            {
+                if (!faces.empty() && faces.size() + 0.5f >= expected_faces) break;
+
+                float scale = detectors.escalation_scales[i];
+                cv::Mat frame_escalated;
+                {
+                    Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_RESIZE);
+                    cv::resize(frame, frame_escalated, cv::Size(), scale, scale, cv::INTER_LINEAR);
+                }
+                Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_DETECTION);
+                std::vector<dlib::rectangle> found =
+                    detectors.escalation[i](dlib::cv_image<pixel_type>(frame_escalated));
+                timer.stop();
+
+                float r = m_frame_scale / scale;
+                for (const dlib::rectangle& f : found)
+                {
+                    dlib::rectangle face(
+                        (long)std::round(f.left() * r), (long)std::round(f.top() * r),
+                        (long)std::round(f.right() * r), (long)std::round(f.bottom() * r));
+                    if (std::none_of(faces.begin(), faces.end(),
+                        [&](const dlib::rectangle& other) { return overlaps(face, other); }))
+                        faces.push_back(face);
+                }
+            }
+        }
+
+        /** Extract the landmarks of all the faces in the frame.
+        If prev_faces is not null, the faces are searched according to the previous
+        frame's faces and the detection mode instead of scanning the entire frame.
+        If warm_faces is not null, the landmarks of detected faces are predicted
+        starting from the overlapping faces' landmarks. When the entire frame is
+        scanned and fewer than expected_faces are found, the detection escalates to
+        the adaptive scales.
+        Returns true if the face detector was used on the entire frame.
+        */
+        bool extract_landmarks(FrameContext& context, Frame& sfl_frame,
+            FaceDetectors& detectors,
+            const std::vector<Face>* prev_faces = nullptr,
+            const std::vector<Face>* warm_faces = nullptr,
+            float expected_faces = 0) const
+        {
+            // Extract landmarks by number of channels
+            if (context.getFrame().channels() == 3)  // BGR
+                return extract_landmarks<dlib::bgr_pixel>(context, sfl_frame, detectors,
+                    prev_faces, warm_faces, expected_faces);
+            else // grayscale
+                return extract_landmarks<unsigned char>(context, sfl_frame, detectors,
+                    prev_faces, warm_faces, expected_faces);
+        }
+
 		template<typename pixel_type>
-		void extract_landmarks(const cv::Mat& frame, Frame& sfl_frame)
+		bool extract_landmarks(FrameContext& context, Frame& sfl_frame,
+            FaceDetectors& detectors, const std::vector<Face>* prev_faces,
+            const std::vector<Face>* warm_faces, float expected_faces) const
 		{
 			// Scaling
-			cv::Mat frame_scaled;
-			if (m_frame_scale != 1.0f)
-				cv::resize(frame, frame_scaled, cv::Size(),
-					m_frame_scale, m_frame_scale);
-			else frame_scaled = frame;
+			const cv::Mat& frame_scaled = context.getScaled();
 
 			// Convert OpenCV's mat to dlib format 
 			dlib::cv_image<pixel_type> dlib_frame(frame_scaled);
 
-			// Detect bounding boxes around all the faces in the image.
-			std::vector<dlib::rectangle> faces = m_detector(dlib_frame);
+            std::vector<dlib::rectangle> faces;
+            std::vector<dlib::full_object_detection> shapes;
+            bool detect = prev_faces == nullptr;
+            if (!detect && m_detection_mode == DETECTION_KEYFRAMES)
+            {
+                // Find the faces from the previous frame's landmarks
+                Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_SHAPE_PREDICTION);
+                detect = !find_faces_from_seeds(dlib_frame, *prev_faces, faces, shapes);
+            }
+            else if (!detect && m_detection_mode == DETECTION_FLOW)
+            {
+                // Carry the previous frame's landmarks forward and refine them
+                detect = !find_faces_from_flow(context, dlib_frame, *prev_faces, faces, shapes);
+            }
+            else if (!detect && m_detection_mode == DETECTION_ROI)
+            {
+                // Detect faces only around the previous frame's faces
+                detect_faces_in_rois<pixel_type>(frame_scaled, *prev_faces,
+                    detectors.detector, faces);
+            }
+
+            // Detect bounding boxes around all the faces in the image.
+            // The detectors are timed individually so the resizing is not timed twice
+            if (detect)
+            {
+                faces = detect_faces<pixel_type>(frame_scaled, detectors.detector);
+                escalate_detection<pixel_type>(context.getFrame(), detectors,
+                    expected_faces, faces);
+                shapes.clear();
+            }
+
+            // Find the pose of each face we detected.
+            if (shapes.empty())
+            {
+                Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_SHAPE_PREDICTION);
+                shapes.reserve(faces.size());
+                for (const dlib::rectangle& dlib_face : faces)
+                {
+                    const Face* warm_face = warm_faces ?
+                        find_overlapping_face(dlib_face, *warm_faces) : nullptr;
+                    if (warm_face)
+                    {
+                        std::vector<dlib::vector<double, 2>> seed;
+                        scaled_landmarks(*warm_face, cv::Point2f(), seed);
+                        shapes.push_back(predict_shape(dlib_frame, dlib_face, &seed,
+                            m_warm_start_cascades));
+                    }
+                    else shapes.push_back(predict_shape(dlib_frame, dlib_face));
+                }
+            }
 
-			// Find the pose of each face we detected.
-			std::vector<dlib::full_object_detection> shapes;
 			//frame_landmarks.faces.resize(faces.size());
 			for (size_t i = 0; i < faces.size(); ++i)
 			{
 				std::unique_ptr<Face> face = std::make_unique<Face>();
-				dlib::rectangle& dlib_face = faces[i];
 
 				// Set face id
 				face->id = i;
 
 				// Set landmarks
-				dlib::full_object_detection shape = m_pose_model(dlib_frame, dlib_face);
-				dlib_obj_to_points(shape, face->landmarks);
+				dlib_obj_to_points(shapes[i], face->landmarks);
 
 				// Scale landmarks to the original frame's pixel coordinates
 				for (size_t j = 0; j < face->landmarks.size(); ++j)
@@ -275,10 +818,319 @@ namespace sfl
 
 				sfl_frame.faces.push_back(std::move(face));
 			}
+
+            return detect;
 		}
 
+        /** Find the faces in the frame by running the shape predictor on the
+        bounding boxes of the previous frame's faces.
+        The bounding boxes are then moved and scaled according to the landmarks.
+        Returns false if any of the faces is lost.
+        */
+        template<typename image_type>
+        bool find_faces_from_seeds(const image_type& img, const std::vector<Face>& seeds,
+            std::vector<dlib::rectangle>& faces,
+            std::vector<dlib::full_object_detection>& shapes) const
+        {
+            const float max_shift = 0.25f;  // Relative to the bounding box size
+            const float max_scale = 1.25f;
+            const dlib::rectangle img_rect = dlib::get_rect(img);
+
+            faces.reserve(seeds.size());
+            shapes.reserve(seeds.size());
+            for (const Face& seed : seeds)
+            {
+                if (seed.landmarks.empty()) return false;
+
+                // Run the shape predictor on the previous bounding box
+                cv::Rect2f bbox(seed.bbox.x * m_frame_scale, seed.bbox.y * m_frame_scale,
+                    seed.bbox.width * m_frame_scale, seed.bbox.height * m_frame_scale);
+                dlib::rectangle rect((long)std::round(bbox.x), (long)std::round(bbox.y),
+                    (long)std::round(bbox.br().x) - 1, (long)std::round(bbox.br().y) - 1);
+                std::vector<dlib::vector<double, 2>> start;
+                scaled_landmarks(seed, cv::Point2f(), start);
+                dlib::full_object_detection shape =
+                    predict_shape(img, rect, &start, m_warm_start_cascades);
+
+                // Compare the new landmarks to the previous landmarks
+                cv::Point2f prev_center, center;
+                float prev_spread, spread;
+                landmarks_stats(seed.landmarks, m_frame_scale, prev_center, prev_spread);
+                std::vector<cv::Point> landmarks;
+                dlib_obj_to_points(shape, landmarks);
+                landmarks_stats(landmarks, 1.0f, center, spread);
+                cv::Point2f shift = center - prev_center;
+                float scale = prev_spread > 0 ? spread / prev_spread : 0.0f;
+                if (cv::norm(shift) > max_shift * bbox.width ||
+                    scale > max_scale || scale < 1.0f / max_scale)
+                    return false;
+
+                // Move and scale the bounding box according to the landmarks
+                cv::Point2f bbox_center = (bbox.tl() + bbox.br()) * 0.5f + shift;
+                cv::Size2f bbox_size = bbox.size() * scale;
+                dlib::rectangle new_rect = dlib::centered_rect(
+                    dlib::point((long)std::round(bbox_center.x), (long)std::round(bbox_center.y)),
+                    (unsigned long)std::round(bbox_size.width),
+                    (unsigned long)std::round(bbox_size.height));
+                if (!img_rect.contains(dlib::center(new_rect))) return false;
+
+                faces.push_back(new_rect);
+                shapes.push_back(shape);
+            }
+
+            return true;
+        }
+
+        /** Find the faces in the frame by propagating the previous frame's landmarks
+        with pyramidal Lucas-Kanade optical flow, and refining them by running the
+        last stages of the shape predictor from the propagated landmarks, on the
+        bounding boxes moved along with the landmarks.
+        Returns false if any of the faces is lost: the flow failed for too many
+        landmarks, the forward-backward error is too large, or the refined landmarks
+        drifted from the propagated landmarks.
+        */
+        template<typename image_type>
+        bool find_faces_from_flow(FrameContext& context, const image_type& img,
+            const std::vector<Face>& prev_faces, std::vector<dlib::rectangle>& faces,
+            std::vector<dlib::full_object_detection>& shapes) const
+        {
+            const float max_fb_error = 1.0f;       // Median, in scaled frame pixels
+            const float min_valid = 0.5f;          // Ratio of the landmarks
+            const float max_drift = 0.1f;          // Relative to the bounding box size
+            const cv::Mat& gray = context.getScaledGray();
+            if (m_prev_gray.empty() || m_prev_gray.size() != gray.size()) return false;
+            const dlib::rectangle img_rect = dlib::get_rect(img);
+
+            // Gather the landmarks of all the faces so the flow is computed at once
+            std::vector<cv::Point2f> prev_points, next_points, back_points;
+            for (const Face& face : prev_faces)
+            {
+                if (face.landmarks.empty()) return false;
+                for (const cv::Point& p : face.landmarks)
+                    prev_points.push_back(cv::Point2f(p) * m_frame_scale);
+            }
+
+            // Forward and backward flow
+            std::vector<unsigned char> status, back_status;
+            std::vector<float> error;
+            {
+                Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_OPTICAL_FLOW);
+                const cv::Size win_size(21, 21);
+                const int max_level = 3;
+                cv::calcOpticalFlowPyrLK(m_prev_gray, gray, prev_points, next_points,
+                    status, error, win_size, max_level);
+                back_points = prev_points;
+                cv::calcOpticalFlowPyrLK(gray, m_prev_gray, next_points, back_points,
+                    back_status, error, win_size, max_level, cv::TermCriteria(
+                    cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 30, 0.01),
+                    cv::OPTFLOW_USE_INITIAL_FLOW);
+            }
+
+            Profiler::ScopedTimer timer(m_profiler.get(), PROFILE_SHAPE_PREDICTION);
+            faces.reserve(prev_faces.size());
+            shapes.reserve(prev_faces.size());
+            size_t offset = 0;
+            for (const Face& face : prev_faces)
+            {
+                size_t n = face.landmarks.size();
+
+                // Forward-backward error and displacement of the tracked landmarks
+                std::vector<float> fb_errors;
+                std::vector<cv::Point2f> points;
+                fb_errors.reserve(n);
+                points.reserve(n);
+                cv::Point2f shift;
+                for (size_t i = offset; i < offset + n; ++i)
+                {
+                    if (!status[i] || !back_status[i]) continue;
+                    fb_errors.push_back((float)cv::norm(back_points[i] - prev_points[i]));
+                    points.push_back(next_points[i]);
+                    shift += next_points[i] - prev_points[i];
+                }
+                offset += n;
+                if (fb_errors.size() < min_valid * n) return false;
+                std::nth_element(fb_errors.begin(), fb_errors.begin() + fb_errors.size() / 2,
+                    fb_errors.end());
+                if (fb_errors[fb_errors.size() / 2] > max_fb_error) return false;
+                shift /= (float)points.size();
+
+                // Move the bounding box along with the landmarks and refine them
+                cv::Rect2f bbox(face.bbox.x * m_frame_scale + shift.x,
+                    face.bbox.y * m_frame_scale + shift.y,
+                    face.bbox.width * m_frame_scale, face.bbox.height * m_frame_scale);
+                dlib::rectangle rect((long)std::round(bbox.x), (long)std::round(bbox.y),
+                    (long)std::round(bbox.br().x) - 1, (long)std::round(bbox.br().y) - 1);
+                if (!img_rect.contains(dlib::center(rect))) return false;
+                std::vector<dlib::vector<double, 2>> start;
+                scaled_landmarks(face, shift, start);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    size_t k = offset - n + i;
+                    if (status[k] && back_status[k])
+                        start[i] = dlib::vector<double, 2>(next_points[k].x, next_points[k].y);
+                }
+                dlib::full_object_detection shape =
+                    predict_shape(img, rect, &start, m_flow_refine_cascades);
+
+                // Compare the refined landmarks to the propagated landmarks
+                cv::Point2f center, flow_center;
+                float spread;
+                std::vector<cv::Point> landmarks;
+                dlib_obj_to_points(shape, landmarks);
+                landmarks_stats(landmarks, 1.0f, center, spread);
+                for (const cv::Point2f& p : points) flow_center += p;
+                flow_center /= (float)points.size();
+                if (cv::norm(center - flow_center) > max_drift * bbox.width) return false;
+
+                faces.push_back(rect);
+                shapes.push_back(shape);
+            }
+
+            return true;
+        }
+
+        /** Detect faces only in regions around the previous frame's faces.
+        The regions are the previous bounding boxes expanded on each side, regions
+        that overlap are merged so each face is searched once.
+        */
+        template<typename pixel_type>
+        void detect_faces_in_rois(const cv::Mat& frame_scaled, const std::vector<Face>& prev_faces,
+            dlib::frontal_face_detector& detector, std::vector<dlib::rectangle>& faces) const
+        {
+            const float margin = 0.5f;  // Relative to the bounding box size
+            const cv::Rect frame_rect(0, 0, frame_scaled.cols, frame_scaled.rows);
+
+            // Calculate regions of interest
+            std::vector<cv::Rect> rois;
+            rois.reserve(prev_faces.size());
+            for (const Face& face : prev_faces)
+            {
+                cv::Rect2f bbox(face.bbox.x * m_frame_scale, face.bbox.y * m_frame_scale,
+                    face.bbox.width * m_frame_scale, face.bbox.height * m_frame_scale);
+                float d = margin * std::max(bbox.width, bbox.height);
+                cv::Rect roi((int)std::floor(bbox.x - d), (int)std::floor(bbox.y - d),
+                    (int)std::ceil(bbox.width + 2 * d), (int)std::ceil(bbox.height + 2 * d));
+                roi &= frame_rect;
+                if (roi.area() > 0) rois.push_back(roi);
+            }
+
+            // Merge overlapping regions
+            for (bool merged = true; merged;)
+            {
+                merged = false;
+                for (size_t i = 0; i < rois.size() && !merged; ++i)
+                {
+                    for (size_t j = i + 1; j < rois.size(); ++j)
+                    {
+                        if ((rois[i] & rois[j]).area() == 0) continue;
+                        rois[i] |= rois[j];
+                        rois.erase(rois.begin() + j);
+                        merged = true;
+                        break;
+                    }
+                }
+            }
+
+            // Detect faces in each region and translate them to frame coordinates
+            for (const cv::Rect& roi : rois)
+            {
+                std::vector<dlib::rectangle> roi_faces =
+                    detect_faces<pixel_type>(frame_scaled(roi), detector);
+                for (const dlib::rectangle& roi_face : roi_faces)
+                    faces.push_back(dlib::translate_rect(roi_face, roi.x, roi.y));
+            }
+        }
+
+        /** Predict the landmarks of a face.
+        Only the cascade stages and trees set by setPredictorCascades and
+        setPredictorTrees are evaluated, by the engine set by setPredictorEngine.
+        If start is not null and cascades is positive, the prediction starts from the
+        specified landmarks and runs only the last cascades of these stages.
+        @param start Initial landmarks in the scaled frame's coordinates.
+        @param cascades Number of stages run from the initial landmarks.
+        */
+        template<typename image_type>
+        dlib::full_object_detection predict_shape(const image_type& img,
+            const dlib::rectangle& rect,
+            const std::vector<dlib::vector<double, 2>>* start = nullptr,
+            int cascades = 0) const
+        {
+            // The regressor is only created when dlib's shape predictor can't be used
+            bool warm = cascades > 0 && start != nullptr;
+            if (!warm && m_predictor_engine == PREDICTOR_DLIB && m_predictor_cascades == 0 &&
+                m_predictor_trees == 0)
+                return m_model->pose_model(img, rect);
+
+            const ShapeRegressor& regressor = m_model->getRegressor();
+            unsigned long last = regressor.numCascades();
+            if (m_predictor_cascades > 0)
+                last = std::min(last, (unsigned long)m_predictor_cascades);
+            bool packed = m_predictor_engine == PREDICTOR_PACKED;
+
+            unsigned long first = 0;
+            if (warm && (unsigned long)cascades < last)
+                first = last - cascades;
+            return regressor.predict(img, rect, warm ? start : nullptr, first, last,
+                (unsigned long)m_predictor_trees, packed);
+        }
+
+        /** Find the face whose bounding box overlaps the most with a detected face.
+        Returns null if no face overlaps with at least half of their union.
+        */
+        const Face* find_overlapping_face(const dlib::rectangle& rect,
+            const std::vector<Face>& faces) const
+        {
+            const double min_iou = 0.5;
+            cv::Rect2f r1((float)rect.left(), (float)rect.top(),
+                (float)rect.width(), (float)rect.height());
+            const Face* best_face = nullptr;
+            double best_iou = min_iou;
+            for (const Face& face : faces)
+            {
+                cv::Rect2f r2(face.bbox.x * m_frame_scale, face.bbox.y * m_frame_scale,
+                    face.bbox.width * m_frame_scale, face.bbox.height * m_frame_scale);
+                double intersection = (r1 & r2).area();
+                double area = r1.area() + r2.area() - intersection;
+                double iou = area > 0 ? intersection / area : 0.0;
+                if (iou >= best_iou && !face.landmarks.empty())
+                {
+                    best_iou = iou;
+                    best_face = &face;
+                }
+            }
+            return best_face;
+        }
+
+        /** Convert a face's landmarks to the scaled frame's coordinates and shift them.
+        */
+        void scaled_landmarks(const Face& face, const cv::Point2f& shift,
+            std::vector<dlib::vector<double, 2>>& points) const
+        {
+            points.resize(face.landmarks.size());
+            for (size_t i = 0; i < face.landmarks.size(); ++i)
+                points[i] = dlib::vector<double, 2>(face.landmarks[i].x * m_frame_scale + shift.x,
+                    face.landmarks[i].y * m_frame_scale + shift.y);
+        }
+
+        /** Calculate the center and the average distance from the center of
+        landmarks scaled by the specified factor.
+        */
+        static void landmarks_stats(const std::vector<cv::Point>& landmarks, float scale,
+            cv::Point2f& center, float& spread)
+        {
+            center = cv::Point2f();
+            spread = 0;
+            if (landmarks.empty()) return;
+            for (const cv::Point& p : landmarks)
+                center += cv::Point2f(p) * scale;
+            center /= (float)landmarks.size();
+            for (const cv::Point& p : landmarks)
+                spread += (float)cv::norm(cv::Point2f(p) * scale - center);
+            spread /= (float)landmarks.size();
+        }
+
 		void dlib_obj_to_points(const dlib::full_object_detection& obj,
-			std::vector<cv::Point>& points)
+			std::vector<cv::Point>& points) const
 		{
 			points.resize(obj.num_parts());
 			for (unsigned long i = 0; i < obj.num_parts(); ++i)
@@ -297,11 +1149,43 @@ namespace sfl
 		float m_frame_scale;
 		int m_frame_counter;
         FaceTrackingType m_tracking;
+        int m_tracking_max_age = 0;
+        int m_tracking_max_lost = -1;
 		std::shared_ptr<FaceTracker> m_face_tracker;
+        FrameSink m_sink;
+        mutable FlatSequence m_flat;
+        mutable bool m_flat_valid = false;
+        std::shared_ptr<Profiler> m_profiler;
 
 		// dlib
-		dlib::frontal_face_detector m_detector;
-		dlib::shape_predictor m_pose_model;
+        std::shared_ptr<const FaceModel> m_model;
+        FaceDetectors m_detectors;
+
+        // Detection
+        FaceDetectionMode m_detection_mode;
+        int m_detection_interval;
+        int m_warm_start_cascades = 0;
+        int m_flow_refine_cascades = 3;
+        int m_min_face_size = 0;
+        int m_max_face_size = 0;
+        std::vector<float> m_adaptive_scales;
+        float m_recent_faces = 0;   ///< Recent average number of faces per frame
+
+        // Shape prediction
+        int m_predictor_cascades = 0;
+        int m_predictor_trees = 0;
+        ShapePredictorEngine m_predictor_engine = PREDICTOR_DLIB;
+        bool m_detection_requested = false;
+        int m_frames_since_detection = 0;
+        int m_prev_frame_id = -1;
+        std::vector<Face> m_prev_faces;
+        cv::Mat m_prev_gray;    ///< Previous scaled grayscale frame, used in DETECTION_FLOW mode
+
+        // Asynchronous processing
+        int m_threads;
+        std::unique_ptr<ThreadPool> m_pool;
+        std::vector<FaceDetectors> m_worker_detectors;
+        std::deque<PendingFrame> m_pending;
 	};
 
 	std::shared_ptr<SequenceFaceLandmarks> SequenceFaceLandmarks::create(
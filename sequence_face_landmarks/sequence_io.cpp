@@ -0,0 +1,253 @@
+#include "sfl/sequence_io.h"
+#include "io_conversion.h"
+
+// std
+#include <fstream>
+#include <exception>
+#include <cstring>
+#include <cstdint>
+
+using std::runtime_error;
+
+namespace sfl
+{
+#ifdef WITH_PROTOBUF
+
+    // Streamed files start with this magic followed by the format version. A file
+    // written by SequenceFaceLandmarks::save can't start with it because 'S' would
+    // be a group start tag which is not used by proto3.
+    const char STREAM_MAGIC[4] = { 'S', 'F', 'L', 'S' };
+    const uint32_t STREAM_VERSION = 1;
+
+    void convert(const Frame& frame, io::Frame& io_frame)
+    {
+        io_frame.set_id((unsigned int)frame.id);
+        io_frame.set_width(frame.width);
+        io_frame.set_height(frame.height);
+
+        // For each face detected in the frame
+        for (auto& face : frame.faces)
+        {
+            io::Face* io_face = io_frame.add_faces();
+            io_face->set_id((unsigned int)face->id);
+            io::BoundingBox* io_bbox = io_face->mutable_bbox();
+            io_bbox->set_left(face->bbox.x);
+            io_bbox->set_top(face->bbox.y);
+            io_bbox->set_width(face->bbox.width);
+            io_bbox->set_height(face->bbox.height);
+
+            // For each landmark point in the face
+            for (const cv::Point& point : face->landmarks)
+            {
+                io::Point* io_point = io_face->add_landmarks();
+                io_point->set_x(point.x);
+                io_point->set_y(point.y);
+            }
+        }
+    }
+
+    void convert(const io::Frame& io_frame, Frame& frame)
+    {
+        frame.id = (int)io_frame.id();
+        frame.width = (int)io_frame.width();
+        frame.height = (int)io_frame.height();
+        frame.faces.clear();
+
+        // For each face detected in the frame
+        for (const io::Face& io_face : io_frame.faces())
+        {
+            std::unique_ptr<Face> face = std::make_unique<Face>();
+            face->id = io_face.id();
+            const io::BoundingBox& io_bbox = io_face.bbox();
+            face->bbox.x = io_bbox.left();
+            face->bbox.y = io_bbox.top();
+            face->bbox.width = io_bbox.width();
+            face->bbox.height = io_bbox.height();
+            face->landmarks.reserve(io_face.landmarks_size());
+
+            // For each landmark point in the face
+            for (const io::Point& io_point : io_face.landmarks())
+                face->landmarks.push_back(cv::Point(io_point.x(), io_point.y()));
+
+            frame.faces.push_back(std::move(face));
+        }
+    }
+
+    static void writeVarint32(std::ostream& out, uint32_t value)
+    {
+        char buf[5];
+        int n = 0;
+        while (value >= 0x80)
+        {
+            buf[n++] = (char)(value | 0x80);
+            value >>= 7;
+        }
+        buf[n++] = (char)value;
+        out.write(buf, n);
+    }
+
+    static bool readVarint32(std::istream& in, uint32_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            int c = in.get();
+            if (c == std::istream::traits_type::eof()) return false;
+            value |= (uint32_t)(c & 0x7F) << shift;
+            if ((c & 0x80) == 0) return true;
+        }
+        throw runtime_error("Invalid landmarks file!");
+    }
+
+    static void writeDelimited(std::ostream& out, const google::protobuf::Message& msg)
+    {
+        std::string buf;
+        msg.SerializeToString(&buf);
+        writeVarint32(out, (uint32_t)buf.size());
+        out.write(buf.data(), buf.size());
+    }
+
+    /** Read a length delimited message.
+    Returns false at the end of the file or if the last record was truncated.
+    */
+    static bool readDelimited(std::istream& in, google::protobuf::Message& msg,
+        std::string& buf)
+    {
+        uint32_t size;
+        if (!readVarint32(in, size)) return false;
+        buf.resize(size);
+        if (size > 0 && !in.read(&buf[0], size)) return false;
+        if (!msg.ParseFromString(buf))
+            throw runtime_error("Invalid landmarks file!");
+        return true;
+    }
+
+    class SequenceWriterImpl : public SequenceWriter
+    {
+    public:
+        SequenceWriterImpl(const std::string& filePath, const std::string& inputPath) :
+            m_output(filePath, std::fstream::trunc | std::fstream::binary)
+        {
+            if (!m_output.is_open())
+                throw runtime_error("Failed to open \"" + filePath + "\" for writing!");
+
+            // Write header
+            m_output.write(STREAM_MAGIC, sizeof(STREAM_MAGIC));
+            writeVarint32(m_output, STREAM_VERSION);
+            io::SequenceHeader header;
+            header.set_input_path(inputPath);
+            writeDelimited(m_output, header);
+        }
+
+        ~SequenceWriterImpl()
+        {
+            close();
+        }
+
+        void write(const Frame& frame)
+        {
+            if (!m_output.is_open())
+                throw runtime_error("The landmarks file is closed!");
+            m_io_frame.Clear();
+            convert(frame, m_io_frame);
+            writeDelimited(m_output, m_io_frame);
+        }
+
+        void close()
+        {
+            if (m_output.is_open()) m_output.close();
+        }
+
+    private:
+        std::ofstream m_output;
+        io::Frame m_io_frame;
+    };
+
+    class SequenceReaderImpl : public SequenceReader
+    {
+    public:
+        SequenceReaderImpl(const std::string& filePath) :
+            m_input(filePath, std::ifstream::binary)
+        {
+            if (!m_input.is_open())
+                throw runtime_error("Failed to open \"" + filePath + "\" for reading!");
+
+            // Check for a streamed file
+            char magic[sizeof(STREAM_MAGIC)];
+            m_streamed = m_input.read(magic, sizeof(magic)) &&
+                std::memcmp(magic, STREAM_MAGIC, sizeof(magic)) == 0;
+            if (m_streamed)
+            {
+                uint32_t version;
+                io::SequenceHeader header;
+                if (!readVarint32(m_input, version) || version > STREAM_VERSION ||
+                    !readDelimited(m_input, header, m_buf))
+                    throw runtime_error("Invalid landmarks file!");
+                m_input_path = header.input_path();
+            }
+            else
+            {
+                // Fallback to reading the entire sequence
+                m_input.clear();
+                m_input.seekg(0);
+                m_sequence.ParseFromIstream(&m_input);
+                m_input_path = m_sequence.input_path();
+            }
+        }
+
+        bool read(Frame& frame)
+        {
+            if (m_streamed)
+            {
+                if (!readDelimited(m_input, m_io_frame, m_buf)) return false;
+                convert(m_io_frame, frame);
+                return true;
+            }
+
+            if (m_frame_ind >= m_sequence.frames_size()) return false;
+            convert(m_sequence.frames(m_frame_ind++), frame);
+            return true;
+        }
+
+        const std::string& getInputPath() const { return m_input_path; }
+
+    private:
+        std::ifstream m_input;
+        bool m_streamed;
+        std::string m_input_path;
+        std::string m_buf;
+        io::Frame m_io_frame;
+        io::Sequence m_sequence;
+        int m_frame_ind = 0;
+    };
+
+    std::shared_ptr<SequenceWriter> SequenceWriter::create(const std::string& filePath,
+        const std::string& inputPath)
+    {
+        return std::make_shared<SequenceWriterImpl>(filePath, inputPath);
+    }
+
+    std::shared_ptr<SequenceReader> SequenceReader::create(const std::string& filePath)
+    {
+        return std::make_shared<SequenceReaderImpl>(filePath);
+    }
+
+#else
+    const std::string NO_PROTOBUF_ERROR =
+        "Method is not implemented! Please enable protobuf to use.";
+
+    std::shared_ptr<SequenceWriter> SequenceWriter::create(const std::string& filePath,
+        const std::string& inputPath)
+    {
+        throw runtime_error(NO_PROTOBUF_ERROR);
+        return nullptr;
+    }
+
+    std::shared_ptr<SequenceReader> SequenceReader::create(const std::string& filePath)
+    {
+        throw runtime_error(NO_PROTOBUF_ERROR);
+        return nullptr;
+    }
+#endif // WITH_PROTOBUF
+
+}   // namespace sfl
@@ -3,6 +3,8 @@
 
 // sfl
 #include "sequence_face_landmarks.h"
+#include "profiler.h"
+#include "frame_context.h"
 
 // OpenCV
 #include <opencv2/core.hpp>
@@ -24,6 +26,13 @@ namespace sfl
 		*/
 		virtual void addFrame(const cv::Mat& frame, Frame& sfl_frame) = 0;
 
+		/** @brief Add a frame to process, taking the images from a shared frame context.
+		@param context The context of the frame to process.
+		@param sfl_frame The face landmarks frame to track the faces from. The faces
+		ids will be changed according to previous tracked faces.
+		*/
+		virtual void addFrame(FrameContext& context, Frame& sfl_frame) = 0;
+
 		/** @brief Clear all processed data.
 		*/
 		virtual void clear() = 0;
@@ -31,6 +40,35 @@ namespace sfl
 		/** @brief Create a full copy of the face tracker.
 		*/
 		virtual std::shared_ptr<FaceTracker> clone() = 0;
+
+        /** @brief Get the maximum number of frames a face is kept after it was last seen.
+        */
+        virtual int getMaxAge() const = 0;
+
+        /** @brief Get the maximum number of lost faces that are kept.
+        */
+        virtual int getMaxLost() const = 0;
+
+        /** @brief Set the maximum number of frames a face is kept after it was last seen.
+        Faces that were not seen for longer are forgotten, if they appear again they
+        will get a new id.
+        @param frames Maximum age in frames. If zero or negative, faces are kept until
+        evicted by the maximum number of lost faces.
+        */
+        virtual void setMaxAge(int frames) = 0;
+
+        /** @brief Set the maximum number of lost faces that are kept.
+        Lost faces are faces that were not seen in the last frame. When there are
+        more lost faces than the maximum, the least recently seen faces are evicted.
+        @param faces Maximum number of lost faces. If negative, the number of lost
+        faces is unlimited, which is the default.
+        */
+        virtual void setMaxLost(int faces) = 0;
+
+        /** @brief Set a profiler for timing the tracking stages.
+        @param profiler The profiler to add the timings to, or nullptr to disable timing.
+        */
+        virtual void setProfiler(std::shared_ptr<Profiler> profiler) = 0;
 	};
 
     /** @brief Create an instance of the BRISK face tracker.
@@ -41,6 +79,13 @@ namespace sfl
     */
     std::shared_ptr<FaceTracker> createFaceTrackerLBP();
 
+    /** @brief Create an instance of the motion face tracker.
+    Faces are matched by the overlap of their bounding boxes with the bounding
+    boxes predicted from their landmarks motion. No pixels are accessed, so the
+    frames passed to the tracker may be empty.
+    */
+    std::shared_ptr<FaceTracker> createFaceTrackerMotion();
+
 }   // namespace sfl
 
 #endif	// __SFL_FACE_TRACKER__
@@ -0,0 +1,218 @@
+/** @file
+@brief Contiguous face landmarks sequence storage.
+*/
+
+#ifndef __SFL_FLAT_SEQUENCE__
+#define __SFL_FLAT_SEQUENCE__
+
+// sfl
+#include "sequence_face_landmarks.h"
+
+// std
+#include <vector>
+
+namespace sfl
+{
+    /** @brief Face landmarks sequence stored in flat contiguous arrays.
+
+    Each frame and face field is stored in its own array (structure of arrays).
+    The faces of frame i are in the range [getFrameOffsets()[i], getFrameOffsets()[i + 1])
+    of the face arrays, and the landmarks of face j are in the range
+    [getLandmarkOffsets()[j], getLandmarkOffsets()[j + 1]) of the landmarks array.
+    Appending a frame does not allocate per face, and passes over all the faces
+    or landmarks of the sequence are linear scans over contiguous memory.
+    */
+    class FlatSequence
+    {
+    public:
+
+        /** @brief Read only view of a face in the sequence.
+        */
+        class FaceView
+        {
+        public:
+            FaceView(const FlatSequence& sequence, size_t index) :
+                m_sequence(&sequence), m_index(index) {}
+
+            /** @brief Face index in the sequence's face arrays.
+            */
+            size_t index() const { return m_index; }
+
+            /** @brief Face id.
+            */
+            int id() const { return m_sequence->m_face_ids[m_index]; }
+
+            /** @brief Bounding box.
+            */
+            const cv::Rect& bbox() const { return m_sequence->m_face_bboxes[m_index]; }
+
+            /** @brief Pointer to the first of the face's landmarks.
+            */
+            const cv::Point* landmarks() const
+            {
+                return m_sequence->m_landmarks.data() + m_sequence->m_landmark_offsets[m_index];
+            }
+
+            /** @brief Number of landmarks.
+            */
+            size_t landmarksCount() const
+            {
+                return m_sequence->m_landmark_offsets[m_index + 1] -
+                    m_sequence->m_landmark_offsets[m_index];
+            }
+
+            /** @brief Copy the face to a face structure.
+            */
+            void copyTo(Face& face) const;
+
+        private:
+            const FlatSequence* m_sequence;
+            size_t m_index;
+        };
+
+        /** @brief Read only view of a frame in the sequence.
+        */
+        class FrameView
+        {
+        public:
+            FrameView(const FlatSequence& sequence, size_t index) :
+                m_sequence(&sequence), m_index(index) {}
+
+            /** @brief Frame position in the sequence.
+            */
+            size_t index() const { return m_index; }
+
+            /** @brief Frame id.
+            */
+            int id() const { return m_sequence->m_frame_ids[m_index]; }
+
+            /** @brief Frame width [pixels].
+            */
+            int width() const { return m_sequence->m_frame_widths[m_index]; }
+
+            /** @brief Frame height [pixels].
+            */
+            int height() const { return m_sequence->m_frame_heights[m_index]; }
+
+            /** @brief Number of faces in the frame.
+            */
+            size_t size() const
+            {
+                return m_sequence->m_frame_offsets[m_index + 1] -
+                    m_sequence->m_frame_offsets[m_index];
+            }
+
+            /** @brief Return true if there are no faces in the frame.
+            */
+            bool empty() const { return size() == 0; }
+
+            /** @brief Get the j'th face of the frame.
+            */
+            FaceView operator[](size_t j) const
+            {
+                return FaceView(*m_sequence, m_sequence->m_frame_offsets[m_index] + j);
+            }
+
+            /** @brief Get the position of a face in the frame by id.
+            Return -1 if a face with the specified id is not found.
+            */
+            int findFace(int id) const;
+
+            /** @brief Copy the frame to a frame structure.
+            */
+            void copyTo(Frame& frame) const;
+
+        private:
+            const FlatSequence* m_sequence;
+            size_t m_index;
+        };
+
+        FlatSequence();
+
+        /** @brief Create from a sequence of frames.
+        */
+        explicit FlatSequence(const std::list<std::unique_ptr<Frame>>& sequence);
+
+        /** @brief Replace the content with a sequence of frames.
+        */
+        void assign(const std::list<std::unique_ptr<Frame>>& sequence);
+
+        /** @brief Append a frame to the end of the sequence.
+        */
+        void append(const Frame& frame);
+
+        /** @brief Remove all frames.
+        The allocated memory is kept for reuse.
+        */
+        void clear();
+
+        /** @brief Reserve memory for the specified number of frames, faces and landmarks.
+        */
+        void reserve(size_t frames, size_t faces, size_t landmarks);
+
+        /** @brief Get the number of frames.
+        */
+        size_t size() const { return m_frame_ids.size(); }
+
+        /** @brief Return true if there are no frames.
+        */
+        bool empty() const { return m_frame_ids.empty(); }
+
+        /** @brief Get the total number of faces in the sequence.
+        */
+        size_t faceCount() const { return m_face_ids.size(); }
+
+        /** @brief Get the total number of landmarks in the sequence.
+        */
+        size_t landmarksCount() const { return m_landmarks.size(); }
+
+        /** @brief Get the i'th frame.
+        */
+        FrameView operator[](size_t i) const { return FrameView(*this, i); }
+
+        /** @brief Get a face by its index in the face arrays.
+        */
+        FaceView face(size_t j) const { return FaceView(*this, j); }
+
+        /** @brief Copy the content to a sequence of frames.
+        */
+        void copyTo(std::list<std::unique_ptr<Frame>>& sequence) const;
+
+        const std::vector<int>& getFrameIDs() const { return m_frame_ids; }
+        const std::vector<int>& getFrameWidths() const { return m_frame_widths; }
+        const std::vector<int>& getFrameHeights() const { return m_frame_heights; }
+
+        /** @brief Face offsets of each frame, size() + 1 elements.
+        */
+        const std::vector<size_t>& getFrameOffsets() const { return m_frame_offsets; }
+
+        const std::vector<int>& getFaceIDs() const { return m_face_ids; }
+        const std::vector<cv::Rect>& getFaceBBoxes() const { return m_face_bboxes; }
+
+        /** @brief Landmark offsets of each face, faceCount() + 1 elements.
+        */
+        const std::vector<size_t>& getLandmarkOffsets() const { return m_landmark_offsets; }
+
+        /** @brief Landmarks of all the faces in the sequence.
+        */
+        const std::vector<cv::Point>& getLandmarks() const { return m_landmarks; }
+
+    private:
+        // Frames
+        std::vector<int> m_frame_ids;
+        std::vector<int> m_frame_widths;
+        std::vector<int> m_frame_heights;
+        std::vector<size_t> m_frame_offsets;
+
+        // Faces
+        std::vector<int> m_face_ids;
+        std::vector<cv::Rect> m_face_bboxes;
+        std::vector<size_t> m_landmark_offsets;
+
+        // Landmarks
+        std::vector<cv::Point> m_landmarks;
+    };
+
+}   // namespace sfl
+
+#endif	// __SFL_FLAT_SEQUENCE__
@@ -0,0 +1,67 @@
+/** @file
+@brief Per frame cache of the images derived from a frame.
+*/
+
+#ifndef __SFL_FRAME_CONTEXT__
+#define __SFL_FRAME_CONTEXT__
+
+// sfl
+#include "profiler.h"
+
+// OpenCV
+#include <opencv2/core.hpp>
+
+namespace sfl
+{
+    /** @brief Lazily computes and shares the images derived from a single frame.
+    The detector, the shape predictor and the trackers all take their input from
+    the same context, so each derived image is computed at most once per frame.
+    A context is not safe for concurrent use, but may be handed over between threads.
+    */
+    class FrameContext
+    {
+    public:
+        /** @brief Create a context for a frame.
+        @param frame The frame [BGR|Grayscale]. The frame is not copied.
+        @param scale Scale factor of the scaled image.
+        @param profiler Optional profiler for timing the conversions.
+        */
+        explicit FrameContext(const cv::Mat& frame, float scale = 1.0f,
+            Profiler* profiler = nullptr);
+
+        /** @brief Get the original frame.
+        */
+        const cv::Mat& getFrame() const { return m_frame; }
+
+        /** @brief Get the scale factor of the scaled image.
+        */
+        float getScale() const { return m_scale; }
+
+        /** @brief Get the frame in grayscale, in the original resolution.
+        */
+        const cv::Mat& getGray();
+
+        /** @brief Get the frame scaled by the scale factor, in its original format.
+        */
+        const cv::Mat& getScaled();
+
+        /** @brief Get the frame scaled by the scale factor, in grayscale.
+        */
+        const cv::Mat& getScaledGray();
+
+        /** @brief Set a profiler for timing the conversions.
+        */
+        void setProfiler(Profiler* profiler) { m_profiler = profiler; }
+
+    private:
+        cv::Mat m_frame;
+        float m_scale;
+        Profiler* m_profiler;
+        cv::Mat m_gray;
+        cv::Mat m_scaled;
+        cv::Mat m_scaled_gray;
+    };
+
+}   // namespace sfl
+
+#endif	// __SFL_FRAME_CONTEXT__
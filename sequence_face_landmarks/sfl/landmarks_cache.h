@@ -0,0 +1,70 @@
+/** @file
+@brief Random access face landmarks cache.
+*/
+
+#ifndef __SFL_LANDMARKS_CACHE__
+#define __SFL_LANDMARKS_CACHE__
+
+// sfl
+#include "sequence_face_landmarks.h"
+#include "sequence_io.h"
+
+namespace sfl
+{
+	/** @brief Random access face landmarks cache file (.lmc).
+
+	The cache file holds a frame index, a face table and fixed stride landmark blocks.
+	The file is memory mapped when opened, so opening is instant regardless of the
+	sequence length, any frame can be fetched in O(1) without reading the rest of the
+	file, and processes opening the same file share the page cache.
+	*/
+	class LandmarksCache
+	{
+	public:
+		virtual ~LandmarksCache() {}
+
+		/** @brief Get the number of frames.
+		*/
+		virtual size_t size() const = 0;
+
+		/** @brief Get source input path.
+		*/
+		virtual const std::string& getInputPath() const = 0;
+
+		/** @brief Get a frame by its position in the sequence.
+		@param i Frame position in the sequence [0, size()).
+		@param frame Output frame.
+		*/
+		virtual void getFrame(size_t i, Frame& frame) const = 0;
+
+		/** @brief Get the number of faces in a frame.
+		@param i Frame position in the sequence [0, size()).
+		*/
+		virtual size_t getFaceCount(size_t i) const = 0;
+
+		/** @brief Open a cache file.
+		@param filePath Path to the cache file (.lmc).
+		*/
+		static std::shared_ptr<LandmarksCache> open(const std::string& filePath);
+
+		/** @brief Write a sequence to a cache file.
+		@param filePath Path to the cache file (.lmc).
+		@param sequence The sequence of frames to write.
+		@param inputPath Path to the source video or image sequence.
+		*/
+		static void write(const std::string& filePath,
+			const std::list<std::unique_ptr<Frame>>& sequence,
+			const std::string& inputPath = "");
+
+		/** @brief Write the frames of a landmarks file to a cache file.
+		The frames are read one at a time, so the sequence is never held in memory.
+		Faces may have any number of landmarks.
+		@param filePath Path to the cache file (.lmc).
+		@param reader Reader of the landmarks file.
+		*/
+		static void write(const std::string& filePath, SequenceReader& reader);
+	};
+
+}   // namespace sfl
+
+#endif	// __SFL_LANDMARKS_CACHE__
@@ -0,0 +1,124 @@
+/** @file
+@brief Per stage timing of the face landmarks pipeline.
+*/
+
+#ifndef __SFL_PROFILER__
+#define __SFL_PROFILER__
+
+// std
+#include <string>
+#include <ostream>
+#include <mutex>
+#include <chrono>
+
+namespace sfl
+{
+    /** @brief Represents a timed stage of the pipeline.
+    */
+    enum ProfileStage
+    {
+        PROFILE_RESIZE = 0,             ///< Frame scaling.
+        PROFILE_COLOR_CONVERSION,       ///< Conversion to grayscale.
+        PROFILE_DETECTION,              ///< Face detection.
+        PROFILE_SHAPE_PREDICTION,       ///< Landmarks shape prediction.
+        PROFILE_TRACKING,               ///< Face tracking, including the tracker stages.
+        PROFILE_BRISK_DETECT,           ///< BRISK keypoints detection.
+        PROFILE_BRISK_COMPUTE,          ///< BRISK descriptors computation.
+        PROFILE_BRISK_MATCH,            ///< BRISK descriptors matching.
+        PROFILE_LBP_PREDICT,            ///< LBP model prediction.
+        PROFILE_LBP_UPDATE,             ///< LBP model training and update.
+        PROFILE_OPTICAL_FLOW,           ///< Landmarks propagation by optical flow.
+        PROFILE_STAGE_COUNT
+    };
+
+    /** @brief Timing statistics of a single stage [milliseconds].
+    */
+    struct ProfileStat
+    {
+        double frame = 0;       ///< Time spent in the last frame.
+        double total = 0;       ///< Time spent in all frames.
+        double max_frame = 0;   ///< Maximum time spent in a single frame.
+        size_t calls = 0;       ///< Number of times the stage was timed.
+    };
+
+    /** @brief Collects the wall time spent in each stage of the pipeline.
+    Time can be added concurrently from multiple threads. The times added between
+    two calls to endFrame are attributed to a single frame. When frames are processed
+    asynchronously, the stages of several frames may overlap so the per frame times
+    are the time spent between commits rather than the time of a specific frame.
+    */
+    class Profiler
+    {
+    public:
+
+        /** @brief Times a stage from construction to destruction.
+        If the profiler is null nothing is timed.
+        */
+        class ScopedTimer
+        {
+        public:
+            ScopedTimer(Profiler* profiler, ProfileStage stage) :
+                m_profiler(profiler), m_stage(stage)
+            {
+                if (m_profiler) m_start = std::chrono::steady_clock::now();
+            }
+
+            ~ScopedTimer() { stop(); }
+
+            /** @brief Stop timing before the timer goes out of scope.
+            */
+            void stop()
+            {
+                if (!m_profiler) return;
+                std::chrono::duration<double, std::milli> elapsed =
+                    std::chrono::steady_clock::now() - m_start;
+                m_profiler->add(m_stage, elapsed.count());
+                m_profiler = nullptr;
+            }
+
+        private:
+            Profiler* m_profiler;
+            ProfileStage m_stage;
+            std::chrono::steady_clock::time_point m_start;
+        };
+
+        /** @brief Add time to a stage.
+        @param stage The stage to add the time to.
+        @param ms Time [milliseconds].
+        */
+        void add(ProfileStage stage, double ms);
+
+        /** @brief Attribute all the time added since the last call to a single frame.
+        */
+        void endFrame();
+
+        /** @brief Clear all statistics.
+        */
+        void clear();
+
+        /** @brief Get the statistics of a stage.
+        */
+        ProfileStat getStat(ProfileStage stage) const;
+
+        /** @brief Get the number of frames.
+        */
+        size_t getFrameCount() const;
+
+        /** @brief Print a summary table of all the stages that were timed.
+        */
+        void print(std::ostream& out) const;
+
+        /** @brief Get stage name.
+        */
+        static const char* getStageName(ProfileStage stage);
+
+    private:
+        mutable std::mutex m_mutex;
+        ProfileStat m_stats[PROFILE_STAGE_COUNT];
+        double m_current[PROFILE_STAGE_COUNT] = {};
+        size_t m_frame_count = 0;
+    };
+
+}   // namespace sfl
+
+#endif	// __SFL_PROFILER__
@@ -4,7 +4,9 @@
 // std
 #include <string>
 #include <list>
+#include <vector>
 #include <memory>
+#include <functional>
 
 // OpenCV
 #include <opencv2/core.hpp>
@@ -35,13 +37,39 @@ namespace sfl
 		const Face* getFace(int id) const;
     };
 
+    class FlatSequence;
+    class Profiler;
+
+    /** @brief Function receiving each processed frame.
+    */
+    typedef std::function<void(const Frame&)> FrameSink;
+
     /** @brief Represents face tracking type.
     */
     enum FaceTrackingType
     {
         TRACKING_NONE = 0,
         TRACKING_BRISK = 1,
-        TRACKING_LBP = 2
+        TRACKING_LBP = 2,
+        TRACKING_MOTION = 3
+    };
+
+    /** @brief Represents face detection mode.
+    */
+    enum FaceDetectionMode
+    {
+        DETECTION_FULL = 0,         ///< Run the face detector on every frame.
+        DETECTION_KEYFRAMES = 1,    ///< Run the face detector on keyframes only.
+        DETECTION_ROI = 2,          ///< Run the face detector around previous faces.
+        DETECTION_FLOW = 3          ///< Propagate the previous faces by optical flow.
+    };
+
+    /** @brief Represents the shape predictor evaluation engine.
+    */
+    enum ShapePredictorEngine
+    {
+        PREDICTOR_DLIB = 0,         ///< dlib's shape predictor.
+        PREDICTOR_PACKED = 1        ///< Packed forests with quantized leaf values, evaluated with SIMD.
     };
 
 	/** @brief Interface for sequence face landmarks functionality.
@@ -58,6 +86,30 @@ namespace sfl
 		*/
 		virtual const Frame& addFrame(const cv::Mat& frame, int id = -1) = 0;
 
+        /** @brief Add a frame to be processed asynchronously.
+        The landmarks of pending frames are extracted concurrently by a pool of worker
+        threads. The results are committed to the sequence (and tracked) in the order
+        the frames were added, so the face ids are identical to calling addFrame.
+        Detection modes other than DETECTION_FULL, warm starts and adaptive scales
+        depend on the previous frames, so with these the frame is processed immediately
+        as in addFrame.
+        @param frame The frame to process [BGR|Grayscale]. The frame is copied.
+        @param id Frame id. If negative, an internal counter will be used instead.
+        */
+        virtual void addFrameAsync(const cv::Mat& frame, int id = -1) = 0;
+
+        /** @brief Add a batch of frames to process.
+        The frames are processed concurrently, this is the same as calling
+        addFrameAsync for each frame followed by flush.
+        @param frames The frames to process [BGR|Grayscale].
+        */
+        virtual void addFrames(const std::vector<cv::Mat>& frames) = 0;
+
+        /** @brief Wait for all the pending frames added by addFrameAsync to be
+        committed to the sequence.
+        */
+        virtual void flush() = 0;
+
 		/** @brief Get the frame sequence with all landmarks and bounding boxes 
 		for each detected face.
 		*/
@@ -68,6 +120,13 @@ namespace sfl
         */
         virtual std::list<std::unique_ptr<Frame>>& getSequenceMutable() = 0;
 
+        /** @brief Get the frame sequence stored in flat contiguous arrays.
+        The flat sequence is updated on demand with the frames added since the last
+        call, and rebuilt after getSequenceMutable is called. The returned reference
+        and its views remain valid until the next non const call.
+        */
+        virtual const FlatSequence& getFlatSequence() const = 0;
+
 		/** @brief Clear all processed or loaded data.
 		*/
 		virtual void clear() = 0;
@@ -85,6 +144,27 @@ namespace sfl
 		*/
 		virtual float getFrameScale() const = 0;
 
+        /** @brief Get the number of shape predictor cascade stages that are evaluated.
+        */
+        virtual int getPredictorCascades() const = 0;
+
+        /** @brief Get the number of trees evaluated in each shape predictor cascade stage.
+        */
+        virtual int getPredictorTrees() const = 0;
+
+        /** @brief Get the shape predictor evaluation engine.
+        */
+        virtual ShapePredictorEngine getPredictorEngine() const = 0;
+
+        /** @brief Get the number of worker threads used by addFrameAsync.
+        */
+        virtual int getThreads() const = 0;
+
+        /** @brief Get the profiler timing the processing stages.
+        Return null if profiling is disabled.
+        */
+        virtual std::shared_ptr<Profiler> getProfiler() const = 0;
+
         /** Get source input path.
         This was either loaded from file or set manually.
         */
@@ -94,6 +174,45 @@ namespace sfl
 		*/
 		virtual FaceTrackingType getTracking() const = 0;
 
+        /** @brief Get the maximum number of frames a tracked face is kept after it
+        was last seen.
+        */
+        virtual int getTrackingMaxAge() const = 0;
+
+        /** @brief Get the maximum number of lost faces kept by the face tracker.
+        */
+        virtual int getTrackingMaxLost() const = 0;
+
+        /** @brief Get the current face detection mode.
+        */
+        virtual FaceDetectionMode getDetectionMode() const = 0;
+
+        /** @brief Get the number of frames between keyframes.
+        */
+        virtual int getDetectionInterval() const = 0;
+
+        /** @brief Get the number of shape predictor cascade stages run when starting
+        from the previous frame's landmarks.
+        */
+        virtual int getWarmStartCascades() const = 0;
+
+        /** @brief Get the number of shape predictor cascade stages run to refine the
+        landmarks propagated by optical flow.
+        */
+        virtual int getFlowRefineCascades() const = 0;
+
+        /** @brief Get the minimum size of the detected faces [pixels].
+        */
+        virtual int getMinFaceSize() const = 0;
+
+        /** @brief Get the maximum size of the detected faces [pixels].
+        */
+        virtual int getMaxFaceSize() const = 0;
+
+        /** @brief Get the frame scales the face detector escalates to.
+        */
+        virtual const std::vector<float>& getAdaptiveScales() const = 0;
+
 		/** @brief Load a sequence of face landmarks from file.
 		*/
 		virtual void load(const std::string& filePath) = 0;
@@ -106,19 +225,154 @@ namespace sfl
 		*/
 		virtual void setFrameScale(float frame_scale) = 0;
 
+        /** @brief Set the number of shape predictor cascade stages that are evaluated.
+        Evaluating only the first stages trades landmarks accuracy for speed, without
+        retraining the model.
+        @param cascades Number of stages. If zero or negative, all the stages are evaluated.
+        */
+        virtual void setPredictorCascades(int cascades) = 0;
+
+        /** @brief Set the number of trees evaluated in each shape predictor cascade stage.
+        Evaluating only the first trees of each stage trades landmarks accuracy for
+        speed, without retraining the model.
+        @param trees Number of trees. If zero or negative, all the trees are evaluated.
+        */
+        virtual void setPredictorTrees(int trees) = 0;
+
+        /** @brief Set the shape predictor evaluation engine [PREDICTOR_DLIB | PREDICTOR_PACKED].
+        PREDICTOR_PACKED evaluates the same model from a cache friendly copy, with
+        landmarks equal to PREDICTOR_DLIB within a fraction of a pixel. If the model
+        can't be packed, dlib's shape predictor is used.
+        */
+        virtual void setPredictorEngine(ShapePredictorEngine engine) = 0;
+
+        /** @brief Set a sink for processed frames.
+        When a sink is set, the sequence is streamed: each frame is passed to the sink
+        after it is processed and tracked, and then released. Only the last frame is
+        kept, so memory usage does not grow with the length of the sequence.
+        The sink is not copied by clone.
+        @param sink Function receiving the frames in the order they were added.
+        Set to nullptr to keep all the frames in the sequence.
+        */
+        virtual void setFrameSink(FrameSink sink) = 0;
+
 		/** @brief Set landmarks model file.
 		*/
 		virtual void setModel(const std::string& modelPath) = 0;
 
+        /** @brief Set the number of worker threads used by addFrameAsync.
+        @param threads Number of threads. If zero or negative, the number of
+        hardware threads will be used instead.
+        */
+        virtual void setThreads(int threads) = 0;
+
+        /** @brief Set a profiler for timing the processing stages.
+        The wall time of scaling, detection, shape prediction and tracking (including
+        the tracker's own stages) is added to the profiler, and a frame is ended on
+        the profiler every time a frame is committed to the sequence.
+        The profiler is not copied by clone.
+        @param profiler The profiler to add the timings to, or nullptr to disable profiling.
+        */
+        virtual void setProfiler(std::shared_ptr<Profiler> profiler) = 0;
+
         /** Get source input path.
         The input path can be then saved and loaded from file.
         */
         virtual void setInputPath(const std::string& inputPath) = 0;
 
-		/** @brief Set tracking type [TRACKING_NONE | TRACKING_BRISK | TRACKING_LBP].
+        /** @brief Set face detection mode
+        [DETECTION_FULL | DETECTION_KEYFRAMES | DETECTION_ROI | DETECTION_FLOW].
+        In DETECTION_KEYFRAMES mode the face detector runs only on keyframes. On the
+        frames in between, the faces are found by running the shape predictor on the
+        bounding boxes of the previous frame's faces. If a face is lost, the face
+        detector will run on that frame instead. New faces are only found on keyframes.
+        In DETECTION_ROI mode the entire frame is scanned only on keyframes. On the
+        frames in between, the face detector runs only on regions around the previous
+        frame's faces.
+        In DETECTION_FLOW mode the previous frame's landmarks are carried to the frame
+        in between keyframes by pyramidal Lucas-Kanade optical flow and refined by the
+        last stages of the shape predictor, see setFlowRefineCascades. If the
+        forward-backward flow error of any face is too large, the face detector will
+        run on that frame instead.
+        */
+        virtual void setDetectionMode(FaceDetectionMode mode) = 0;
+
+        /** @brief Set the number of frames between keyframes.
+        Used in DETECTION_KEYFRAMES, DETECTION_ROI and DETECTION_FLOW modes.
+        */
+        virtual void setDetectionInterval(int interval) = 0;
+
+        /** @brief Run the face detector on the next frame regardless of the
+        detection mode.
+        */
+        virtual void requestDetection() = 0;
+
+        /** @brief Set the number of shape predictor cascade stages run when starting
+        from the previous frame's landmarks.
+        When enabled, the landmarks of a face found near a face of the previous frame
+        are predicted starting from the previous landmarks instead of the model's mean
+        shape, and only the last cascade stages are run. The stages are counted back
+        from the last stage set by setPredictorCascades. Fewer stages are faster but
+        less accurate. Frames are then processed in order even when added asynchronously.
+        @param cascades Number of cascade stages. If zero or negative, the landmarks are
+        always predicted from the mean shape using the entire cascade.
+        */
+        virtual void setWarmStartCascades(int cascades) = 0;
+
+        /** @brief Set the number of shape predictor cascade stages run to refine the
+        landmarks propagated by optical flow in DETECTION_FLOW mode.
+        The prediction always starts from the propagated landmarks, independently of
+        setWarmStartCascades, and runs only the last cascade stages. The stages are
+        counted back from the last stage set by setPredictorCascades. The default is 3.
+        @param cascades Number of cascade stages, at least one stage is run.
+        */
+        virtual void setFlowRefineCascades(int cascades) = 0;
+
+        /** @brief Set the minimum size of the faces the detector searches for.
+        The frame is downscaled for detection so the smallest faces still fill the
+        detector's window, and the pyramid levels of smaller faces are not scanned.
+        @param size Face size in the original frame's pixels, zero for no limit.
+        */
+        virtual void setMinFaceSize(int size) = 0;
+
+        /** @brief Set the maximum size of the faces the detector searches for.
+        The detector's pyramid is cut after the level of the largest faces.
+        Combined with a frame scale larger than 1, only the levels of small faces
+        are scanned on the upscaled frame.
+        @param size Face size in the original frame's pixels, zero for no limit.
+        */
+        virtual void setMaxFaceSize(int size) = 0;
+
+        /** @brief Set the frame scales the face detector escalates to when it finds no
+        faces, or fewer faces than the recent average, at the frame scale.
+        The scales larger than the frame scale are tried in increasing order only on
+        those frames, and each scale scans only the pyramid levels of the faces too
+        small for the previous scale. The landmarks are still predicted on the frame
+        scaled by the frame scale and reported in the original frame's pixels.
+        Frames are then processed in order even when added asynchronously, so the
+        recent average is the same as when calling addFrame.
+        @param scales Frame scales, empty to always detect at the frame scale.
+        */
+        virtual void setAdaptiveScales(const std::vector<float>& scales) = 0;
+
+		/** @brief Set tracking type [TRACKING_NONE | TRACKING_BRISK | TRACKING_LBP | TRACKING_MOTION].
 			This will keep the face ids consistent in the sequence.
 		*/
 		virtual void setTracking(FaceTrackingType tracking) = 0;
+
+        /** @brief Set the maximum number of frames a tracked face is kept after it
+        was last seen, see FaceTracker::setMaxAge.
+        @param frames Maximum age in frames. If zero or negative, faces are kept until
+        evicted by the maximum number of lost faces.
+        */
+        virtual void setTrackingMaxAge(int frames) = 0;
+
+        /** @brief Set the maximum number of lost faces kept by the face tracker, see
+        FaceTracker::setMaxLost.
+        @param faces Maximum number of lost faces. If negative, the number of lost
+        faces is unlimited, which is the default.
+        */
+        virtual void setTrackingMaxLost(int faces) = 0;
 		
 		/** @brief Get the number of the current frames.
 		*/
@@ -128,7 +382,7 @@ namespace sfl
 		@param landmarks_path Path to the landmarks model file or landmarks cache file (.pb).
 		@param frame_scale Each frame will be scaled by this factor. Useful for detection of small
 		faces. The landmarks will still be in the original frame's pixel coordinates.
-        @param tracking Tracking type [TRACKING_NONE | TRACKING_BRISK | TRACKING_LBP].
+        @param tracking Tracking type [TRACKING_NONE | TRACKING_BRISK | TRACKING_LBP | TRACKING_MOTION].
 		*/
 		static std::shared_ptr<SequenceFaceLandmarks> create(
 			const std::string& landmarks_path, float frame_scale = 1.0f,
@@ -137,7 +391,7 @@ namespace sfl
 		/** @brief Create an instance.
 		@param frame_scale Each frame will be scaled by this factor. Useful for detection of small
 		faces. The landmarks will still be in the original frame's pixel coordinates.
-        @param tracking Tracking type [TRACKING_NONE | TRACKING_BRISK | TRACKING_LBP].
+        @param tracking Tracking type [TRACKING_NONE | TRACKING_BRISK | TRACKING_LBP | TRACKING_MOTION].
 		*/
 		static std::shared_ptr<SequenceFaceLandmarks> create(
 			float frame_scale = 1.0f, FaceTrackingType tracking = TRACKING_NONE);
@@ -0,0 +1,69 @@
+/** @file
+@brief Streamed reading and writing of face landmarks sequence files.
+*/
+
+#ifndef __SFL_SEQUENCE_IO__
+#define __SFL_SEQUENCE_IO__
+
+// sfl
+#include "sequence_face_landmarks.h"
+
+namespace sfl
+{
+	/** @brief Writes a sequence of face landmarks to a file one frame at a time.
+
+	The file is made of a header followed by length delimited frame records, so
+	frames are on disk as soon as they are written and nothing is accumulated in
+	memory. The file can be read using SequenceReader or SequenceFaceLandmarks::load.
+	*/
+	class SequenceWriter
+	{
+	public:
+		virtual ~SequenceWriter() {}
+
+		/** @brief Append a frame to the file.
+		*/
+		virtual void write(const Frame& frame) = 0;
+
+		/** @brief Flush and close the file.
+		*/
+		virtual void close() = 0;
+
+		/** @brief Create a writer, an existing file will be overwritten.
+		@param filePath Path to the landmarks file (.lms).
+		@param inputPath Path to the source video or image sequence.
+		*/
+		static std::shared_ptr<SequenceWriter> create(const std::string& filePath,
+			const std::string& inputPath = "");
+	};
+
+	/** @brief Reads a sequence of face landmarks from a file one frame at a time.
+
+	Both streamed files written by SequenceWriter and files written by
+	SequenceFaceLandmarks::save are supported. Only streamed files are read
+	incrementally.
+	*/
+	class SequenceReader
+	{
+	public:
+		virtual ~SequenceReader() {}
+
+		/** @brief Read the next frame.
+		@param frame Output frame.
+		@return false if there are no more frames.
+		*/
+		virtual bool read(Frame& frame) = 0;
+
+		/** @brief Get source input path.
+		*/
+		virtual const std::string& getInputPath() const = 0;
+
+		/** @brief Create a reader.
+		@param filePath Path to the landmarks file (.lms).
+		*/
+		static std::shared_ptr<SequenceReader> create(const std::string& filePath);
+	};
+
+}   // namespace sfl
+
+#endif	// __SFL_SEQUENCE_IO__
@@ -0,0 +1,96 @@
+/** @file
+@brief Fixed size pool of worker threads.
+*/
+
+#ifndef __SFL_THREAD_POOL__
+#define __SFL_THREAD_POOL__
+
+// std
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+namespace sfl
+{
+    /** @brief Fixed size pool of worker threads.
+    Each task receives the index of the worker running it, so callers can keep
+    per worker state (e.g. objects that are not safe for concurrent use).
+    */
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(int threads)
+        {
+            if (threads < 1) threads = 1;
+            m_workers.reserve(threads);
+            for (int i = 0; i < threads; ++i)
+                m_workers.emplace_back([this, i] { run(i); });
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_cond.notify_all();
+            for (std::thread& worker : m_workers)
+                worker.join();
+        }
+
+        /** @brief Number of worker threads.
+        */
+        int size() const { return (int)m_workers.size(); }
+
+        /** @brief Queue a task for execution.
+        @param f Callable with the signature R(int worker_index).
+        @return Future holding the task's result or exception.
+        */
+        template<typename F>
+        auto enqueue(F&& f) -> std::future<decltype(f(0))>
+        {
+            typedef decltype(f(0)) result_type;
+            auto task = std::make_shared<std::packaged_task<result_type(int)>>(
+                std::forward<F>(f));
+            std::future<result_type> result = task->get_future();
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_tasks.push([task](int worker) { (*task)(worker); });
+            }
+            m_cond.notify_one();
+            return result;
+        }
+
+    private:
+        void run(int worker)
+        {
+            for (;;)
+            {
+                std::function<void(int)> task;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_cond.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+                    if (m_stop && m_tasks.empty()) return;
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop();
+                }
+                task(worker);
+            }
+        }
+
+    private:
+        std::vector<std::thread> m_workers;
+        std::queue<std::function<void(int)>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        bool m_stop = false;
+    };
+
+}   // namespace sfl
+
+#endif	// __SFL_THREAD_POOL__
@@ -7,6 +7,7 @@
 
 // sfl
 #include "sequence_face_landmarks.h"
+#include "flat_sequence.h"
 
 namespace sfl
 {
@@ -22,6 +23,19 @@ namespace sfl
 		bool drawLabels = false, const cv::Scalar& color = cv::Scalar(0, 255, 0),
 		int thickness = 1);
 
+	/** @brief Render landmarks stored in contiguous memory.
+	@param img The image that the landmarks will be rendered on.
+	@param landmarks Pointer to the first landmark point.
+	@param count The number of landmark points.
+	@param drawLabels if true, for each landmark, it's 0 based index will be
+	rendererd as a label.
+	@param color Line/point and label color.
+	@param thickness Line/point thickness.
+	*/
+	void render(cv::Mat& img, const cv::Point* landmarks, size_t count,
+		bool drawLabels = false, const cv::Scalar& color = cv::Scalar(0, 255, 0),
+		int thickness = 1);
+
 	/** @brief Render bounding box.
 	@param img The image that the bounding box will be rendered on.
 	@param bbox The bounding box rectangle to render.
@@ -63,9 +77,28 @@ namespace sfl
 		const cv::Scalar& landmarks_color = cv::Scalar(0, 255, 0), int thickness = 1,
 		double fontScale = 1.0);
 
+	/** @brief Render all faces of a flat sequence frame including bounding boxs and landmarks.
+	@param img The image that the faces will be rendered on.
+	@param frame The frame view to render.
+    @param drawIDs if true, the 0 based id will be rendererd as a label.
+	@param drawLabels if true, for each landmark, it's 0 based index will be
+	rendererd as a label.
+	@param bbox_color Bounding box line color.
+	@param landmarks_color Landmarks line/point and label color.
+	@param thickness Line/point thickness.
+    @param fontScale The size of the font for the labels.
+	*/
+	void render(cv::Mat& img, const FlatSequence::FrameView& frame, bool drawIDs = true,
+        bool drawLabels = false, const cv::Scalar& bbox_color = cv::Scalar(0, 0, 255),
+		const cv::Scalar& landmarks_color = cv::Scalar(0, 255, 0), int thickness = 1,
+		double fontScale = 1.0);
+
     void renderFaceID(cv::Mat& img, const Face& face, const cv::Scalar& color, int thickness = 1,
         double fontScale = 1.0);
 
+    void renderFaceID(cv::Mat& img, int id, const cv::Rect& bbox, const cv::Scalar& color,
+        int thickness = 1, double fontScale = 1.0);
+
 
 	/** @brief Represents a face statistics in the sequence.
 	*/
@@ -89,10 +122,20 @@ namespace sfl
 	void getSequenceStats(const std::list<std::unique_ptr<Frame>>& sequence,
 		std::vector<FaceStat>& stats);
 
+	/** @brief Get the face statistics of a flat sequence.
+		@param sequence The sequence of frames to calculate the statistics for.
+		@param stats Output vector of statistics for each face in the sequence.
+	*/
+	void getSequenceStats(const FlatSequence& sequence, std::vector<FaceStat>& stats);
+
 	/** @brief Get the main face in a sequence.
 	*/
 	int getMainFaceID(const std::list<std::unique_ptr<Frame>>& sequence);
 
+	/** @brief Get the main face in a flat sequence.
+	*/
+	int getMainFaceID(const FlatSequence& sequence);
+
 	/** @brief Get the main face from face statistics.
 	*/
 	int getMainFaceID(const std::vector<FaceStat>& stats);
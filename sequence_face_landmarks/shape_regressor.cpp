@@ -0,0 +1,83 @@
+#include "shape_regressor.h"
+
+// std
+#include <sstream>
+#include <exception>
+
+using std::runtime_error;
+
+namespace sfl
+{
+    ShapeRegressor::ShapeRegressor(const dlib::shape_predictor& sp)
+    {
+        // The shape predictor doesn't expose its forests, read them from its
+        // serialized form
+        std::stringstream ss;
+        dlib::serialize(sp, ss);
+        int version = 0;
+        dlib::deserialize(version, ss);
+        if (version != 1)
+            throw runtime_error("Unsupported shape predictor version!");
+        dlib::deserialize(m_initial_shape, ss);
+        dlib::deserialize(m_forests, ss);
+        dlib::deserialize(m_anchor_idx, ss);
+        dlib::deserialize(m_deltas, ss);
+    }
+
+    const std::vector<PackedForest>* ShapeRegressor::packedForests() const
+    {
+        // The packed forests are another copy of the model, they are only created
+        // for the packed engine. Models with irregular trees are only evaluated in
+        // their original layout
+        std::call_once(m_packed_once, [this]
+        {
+            try
+            {
+                m_packed.reserve(m_forests.size());
+                for (const std::vector<dlib::impl::regression_tree>& forest : m_forests)
+                    m_packed.emplace_back(forest);
+            }
+            catch (const runtime_error&)
+            {
+                m_packed.clear();
+            }
+        });
+        return m_packed.empty() ? nullptr : &m_packed;
+    }
+
+    void ShapeRegressor::evaluateCascade(unsigned long cascade,
+        const std::vector<float>& features, unsigned long trees,
+        dlib::matrix<float, 0, 1>& shape) const
+    {
+        const std::vector<dlib::impl::regression_tree>& forest = m_forests[cascade];
+        unsigned long n = (unsigned long)forest.size();
+        if (trees > 0) n = std::min(n, trees);
+        for (unsigned long t = 0; t < n; ++t)
+        {
+            const dlib::impl::regression_tree& tree = forest[t];
+            // Go left while the pixel difference is above the threshold
+            unsigned long i = 0;
+            const unsigned long splits = (unsigned long)tree.splits.size();
+            while (i < splits)
+            {
+                const dlib::impl::split_feature& split = tree.splits[i];
+                if (features[split.idx1] - features[split.idx2] > split.thresh)
+                    i = 2 * i + 1;
+                else
+                    i = 2 * i + 2;
+            }
+            shape += tree.leaf_values[i - splits];
+        }
+    }
+
+    dlib::full_object_detection ShapeRegressor::toDetection(const dlib::rectangle& rect,
+        const dlib::matrix<float, 0, 1>& shape)
+    {
+        const dlib::point_transform_affine tform_to_img = dlib::impl::unnormalizing_tform(rect);
+        std::vector<dlib::point> parts(shape.size() / 2);
+        for (unsigned long i = 0; i < parts.size(); ++i)
+            parts[i] = tform_to_img(dlib::vector<float, 2>(shape(2 * i), shape(2 * i + 1)));
+        return dlib::full_object_detection(rect, parts);
+    }
+
+}   // namespace sfl
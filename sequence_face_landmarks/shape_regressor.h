@@ -0,0 +1,132 @@
+#ifndef __SFL_SHAPE_REGRESSOR__
+#define __SFL_SHAPE_REGRESSOR__
+
+// std
+#include <vector>
+#include <algorithm>
+#include <mutex>
+
+// dlib
+#include <dlib/image_processing/shape_predictor.h>
+
+// sfl
+#include "packed_forest.h"
+
+namespace sfl
+{
+    /** @brief Cascade of regression forests of a dlib shape predictor.
+    Evaluates the same model as dlib::shape_predictor, but allows starting the
+    cascade from a given shape instead of the model's mean shape, and running only
+    part of the cascade. The forests can also be evaluated in a packed layout, which
+    is faster and equal to the original forests within the quantization of the leaf
+    values, created on first use. The model is safe for concurrent use.
+    */
+    class ShapeRegressor
+    {
+    public:
+        ShapeRegressor() {}
+
+        /** @brief Create from a loaded shape predictor.
+        */
+        explicit ShapeRegressor(const dlib::shape_predictor& sp);
+
+        /** @brief Number of landmarks.
+        */
+        unsigned long numParts() const { return (unsigned long)m_initial_shape.size() / 2; }
+
+        /** @brief Number of cascade stages.
+        */
+        unsigned long numCascades() const { return (unsigned long)m_forests.size(); }
+
+        /** @brief Return true if the forests could be packed.
+        The forests are packed on the first call, or on the first packed prediction.
+        */
+        bool isPacked() const { return packedForests() != nullptr; }
+
+        /** @brief Predict the landmarks starting from the model's mean shape.
+        Same as dlib::shape_predictor::operator().
+        */
+        template<typename image_type>
+        dlib::full_object_detection operator()(const image_type& img,
+            const dlib::rectangle& rect) const
+        {
+            return predict(img, rect, m_initial_shape, 0, numCascades(), 0, false);
+        }
+
+        /** @brief Predict the landmarks running part of the cascade.
+        @param img The image.
+        @param rect Face bounding box.
+        @param start Initial landmarks in image coordinates, they are normalized to
+        rect. If null or not of numParts() points, the model's mean shape is used.
+        @param first First cascade stage to run.
+        @param last One past the last cascade stage to run.
+        @param trees Maximum number of trees evaluated in each stage, the first trees
+        make the largest corrections. If zero, all the trees are evaluated.
+        @param packed Evaluate the packed forests if available.
+        */
+        template<typename image_type>
+        dlib::full_object_detection predict(const image_type& img, const dlib::rectangle& rect,
+            const std::vector<dlib::vector<double, 2>>* start, unsigned long first,
+            unsigned long last, unsigned long trees = 0, bool packed = false) const
+        {
+            last = std::min(last, numCascades());
+            if (start == nullptr || start->size() != numParts())
+                return predict(img, rect, m_initial_shape, first, last, trees, packed);
+
+            const dlib::point_transform_affine tform_from_img = dlib::impl::normalizing_tform(rect);
+            dlib::matrix<float, 0, 1> shape(m_initial_shape.size());
+            for (unsigned long i = 0; i < start->size(); ++i)
+            {
+                dlib::vector<double, 2> p = tform_from_img((*start)[i]);
+                shape(2 * i) = (float)p.x();
+                shape(2 * i + 1) = (float)p.y();
+            }
+            return predict(img, rect, shape, first, last, trees, packed);
+        }
+
+    private:
+        template<typename image_type>
+        dlib::full_object_detection predict(const image_type& img, const dlib::rectangle& rect,
+            dlib::matrix<float, 0, 1> shape, unsigned long first, unsigned long last,
+            unsigned long trees, bool packed) const
+        {
+            const std::vector<PackedForest>* packed_forests = packed ? packedForests() : nullptr;
+            std::vector<float> features;
+            for (unsigned long c = first; c < last; ++c)
+            {
+                dlib::impl::extract_feature_pixel_values(img, rect, shape, m_initial_shape,
+                    m_anchor_idx[c], m_deltas[c], features);
+                if (packed_forests) (*packed_forests)[c].evaluate(features.data(), trees, &shape(0));
+                else evaluateCascade(c, features, trees, shape);
+            }
+            return toDetection(rect, shape);
+        }
+
+        /** Add the leaf values of the first trees of a cascade stage to the shape.
+        If trees is zero, all the trees are evaluated.
+        */
+        void evaluateCascade(unsigned long cascade, const std::vector<float>& features,
+            unsigned long trees, dlib::matrix<float, 0, 1>& shape) const;
+
+        /** Get the packed forests, packing them on first use.
+        Returns null if the forests can't be packed.
+        */
+        const std::vector<PackedForest>* packedForests() const;
+
+        /** Convert a normalized shape to landmarks in image coordinates.
+        */
+        static dlib::full_object_detection toDetection(const dlib::rectangle& rect,
+            const dlib::matrix<float, 0, 1>& shape);
+
+    private:
+        dlib::matrix<float, 0, 1> m_initial_shape;
+        std::vector<std::vector<dlib::impl::regression_tree>> m_forests;
+        std::vector<std::vector<unsigned long>> m_anchor_idx;
+        std::vector<std::vector<dlib::vector<float, 2>>> m_deltas;
+        mutable std::once_flag m_packed_once;
+        mutable std::vector<PackedForest> m_packed;
+    };
+
+}   // namespace sfl
+
+#endif	// __SFL_SHAPE_REGRESSOR__
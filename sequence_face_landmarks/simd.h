@@ -0,0 +1,67 @@
+#ifndef __SFL_SIMD__
+#define __SFL_SIMD__
+
+// std
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// SIMD kernels are compiled on x86-64 and selected at runtime by the CPU features,
+// translation units with kernels include <immintrin.h> when SFL_X64 is defined
+#if defined(__x86_64__) || defined(_M_X64)
+#define SFL_X64
+#endif
+
+// Allow compiling the kernels for instruction sets not enabled for the whole build
+#if defined(__GNUC__) || defined(__clang__)
+#define SFL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SFL_TARGET(isa)
+#endif
+
+namespace sfl
+{
+    /** @brief Array whose elements start on a 64 bytes (cache line) boundary.
+    */
+    template<typename T>
+    class AlignedArray
+    {
+    public:
+        AlignedArray() {}
+        AlignedArray(const AlignedArray& a) { *this = a; }
+        AlignedArray(AlignedArray&& a) = default;
+        AlignedArray& operator=(AlignedArray&& a) = default;
+
+        AlignedArray& operator=(const AlignedArray& a)
+        {
+            if (this == &a) return *this;
+            resize(a.m_size);
+            std::copy(a.data(), a.data() + a.m_size, data());
+            return *this;
+        }
+
+        /** @brief Resize the array, the elements are zero initialized.
+        */
+        void resize(size_t size)
+        {
+            m_buffer.assign(size * sizeof(T) + 63, 0);
+            m_size = size;
+        }
+
+        size_t size() const { return m_size; }
+        T* data() { return (T*)(m_buffer.data() + padding()); }
+        const T* data() const { return (const T*)(m_buffer.data() + padding()); }
+        T& operator[](size_t i) { return data()[i]; }
+        const T& operator[](size_t i) const { return data()[i]; }
+
+    private:
+        size_t padding() const { return (64 - (uintptr_t)m_buffer.data() % 64) % 64; }
+
+    private:
+        std::vector<uint8_t> m_buffer;
+        size_t m_size = 0;
+    };
+
+}   // namespace sfl
+
+#endif	// __SFL_SIMD__
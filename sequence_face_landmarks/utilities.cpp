@@ -1,4 +1,5 @@
 #include "sfl/utilities.h"
+#include "sfl/flat_sequence.h"
 
 // std
 #include <map>
@@ -15,7 +16,13 @@ namespace sfl
 	void render(cv::Mat & img, const std::vector<cv::Point>& landmarks,
 		bool drawLabels, const cv::Scalar & color, int thickness)
 	{
-		if (landmarks.size() == 68)
+		render(img, landmarks.data(), landmarks.size(), drawLabels, color, thickness);
+	}
+
+	void render(cv::Mat& img, const cv::Point* landmarks, size_t count,
+		bool drawLabels, const cv::Scalar& color, int thickness)
+	{
+		if (count == 68)
 		{
 			for (size_t i = 1; i <= 16; ++i)
 				cv::line(img, landmarks[i], landmarks[i - 1], color, thickness);
@@ -51,14 +58,14 @@ namespace sfl
 		}
 		else
 		{
-			for (size_t i = 0; i < landmarks.size(); ++i)
+			for (size_t i = 0; i < count; ++i)
 				cv::circle(img, landmarks[i], thickness, color, -1);
 		}
 
 		if (drawLabels)
 		{
 			// Add labels
-			for (size_t i = 0; i < landmarks.size(); ++i)
+			for (size_t i = 0; i < count; ++i)
 				cv::putText(img, std::to_string(i), landmarks[i],
 					cv::FONT_HERSHEY_PLAIN, 0.5, color, thickness);
 		}
@@ -90,27 +97,49 @@ namespace sfl
 				fontScale);
 	}
 
+	void render(cv::Mat& img, const FlatSequence::FrameView& frame, bool drawIDs,
+		bool drawLabels, const cv::Scalar& bbox_color, const cv::Scalar& landmarks_color,
+		int thickness, double fontScale)
+	{
+		for (size_t j = 0; j < frame.size(); ++j)
+		{
+			FlatSequence::FaceView face = frame[j];
+			render(img, face.bbox(), bbox_color, thickness);
+			render(img, face.landmarks(), face.landmarksCount(), drawLabels,
+				landmarks_color, thickness);
+			if (drawIDs) renderFaceID(img, face.id(), face.bbox(), bbox_color, thickness,
+				fontScale);
+		}
+	}
+
     void renderFaceID(cv::Mat& img, const Face& face, const cv::Scalar& color,
         int thickness, double fontScale)
     {
-        std::string lbl = std::to_string(face.id);
+        renderFaceID(img, face.id, face.bbox, color, thickness, fontScale);
+    }
+
+    void renderFaceID(cv::Mat& img, int id, const cv::Rect& bbox, const cv::Scalar& color,
+        int thickness, double fontScale)
+    {
+        std::string lbl = std::to_string(id);
         int baseline = 0;
         cv::Size textSize = cv::getTextSize(lbl, cv::FONT_HERSHEY_PLAIN,
             fontScale, thickness, &baseline);
-        cv::Point lbl_pt(face.bbox.x + (face.bbox.width - textSize.width) / 2,
-            face.bbox.y - textSize.height / 4);
-        cv::putText(img, std::to_string(face.id), lbl_pt,
-            cv::FONT_HERSHEY_PLAIN, fontScale, color, thickness);
+        cv::Point lbl_pt(bbox.x + (bbox.width - textSize.width) / 2,
+            bbox.y - textSize.height / 4);
+        cv::putText(img, lbl, lbl_pt, cv::FONT_HERSHEY_PLAIN, fontScale, color, thickness);
     }
 
+	static void finalizeSequenceStats(std::vector<FaceStat>& stats, int total_frames,
+		float avg_frame_width, float avg_frame_height);
+
 	void getSequenceStats(const std::list<std::unique_ptr<Frame>>& sequence,
 		std::vector<FaceStat>& stats)
 	{
 		std::map<int, int> face_map;
 		int total_frames = 0;
 		cv::Point2f center, pos;
-		float dist, max_dist = 0;
-		float size, max_size = 0;
+		float dist, size;
 		float avg_frame_width = 0, avg_frame_height = 0;
 
 		// For each frame
@@ -157,6 +186,63 @@ namespace sfl
 			}
 		}
 
+		finalizeSequenceStats(stats, total_frames, avg_frame_width, avg_frame_height);
+	}
+
+	void getSequenceStats(const FlatSequence& sequence, std::vector<FaceStat>& stats)
+	{
+		std::map<int, int> face_map;
+		int total_frames = 0;
+		float avg_frame_width = 0, avg_frame_height = 0;
+		const std::vector<size_t>& frame_offsets = sequence.getFrameOffsets();
+		const int* face_ids = sequence.getFaceIDs().data();
+		const cv::Rect* bboxes = sequence.getFaceBBoxes().data();
+
+		// For each frame
+		for (size_t i = 0; i < sequence.size(); ++i)
+		{
+			size_t begin = frame_offsets[i], end = frame_offsets[i + 1];
+			if (begin == end) continue;
+			++total_frames;
+
+			int width = sequence.getFrameWidths()[i], height = sequence.getFrameHeights()[i];
+			float cx = width*0.5f, cy = height*0.5f;
+			avg_frame_width += (float)width;
+			avg_frame_height += (float)height;
+
+			// For each face
+			for (size_t j = begin; j < end; ++j)
+			{
+				// Get face stat
+				int id = face_ids[j];
+				int k = face_map[id];
+				if (k >= stats.size() || id != stats[k].id)
+				{
+					// Create new face stat
+					stats.push_back(FaceStat());
+					k = stats.size() - 1;
+					face_map[id] = k;
+					stats[k].id = id;
+				}
+				FaceStat& face_stat = stats[k];
+
+				// Add center distance, frame count and face size
+				const cv::Rect& bbox = bboxes[j];
+				float dx = bbox.x + bbox.width*0.5f - cx;
+				float dy = bbox.y + bbox.height*0.5f - cy;
+				face_stat.avg_center_dist += std::sqrt(dx*dx + dy*dy);
+				++(face_stat.frame_count);
+				face_stat.avg_size += (bbox.width + bbox.height)*0.5f;
+			}
+		}
+
+		finalizeSequenceStats(stats, total_frames, avg_frame_width, avg_frame_height);
+	}
+
+	static void finalizeSequenceStats(std::vector<FaceStat>& stats, int total_frames,
+		float avg_frame_width, float avg_frame_height)
+	{
+		float max_dist, max_size;
 		if (total_frames == 0) return;
 
 		// Calculate averages and ranges
@@ -197,6 +283,13 @@ namespace sfl
 		return getMainFaceID(stats);
 	}
 
+	int getMainFaceID(const FlatSequence& sequence)
+	{
+		std::vector<FaceStat> stats;
+		getSequenceStats(sequence, stats);
+		return getMainFaceID(stats);
+	}
+
 	int getMainFaceID(const std::vector<FaceStat>& stats)
 	{
 		int best_id = -1;
@@ -0,0 +1,737 @@
+// std
+#include <iostream>
+#include <fstream>
+#include <exception>
+#include <chrono>
+#include <map>
+#include <algorithm>
+#include <numeric>
+#include <iomanip>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <tuple>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Boost
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+
+// sfl
+#include <sfl/sequence_face_landmarks.h>
+#include <sfl/face_tracker.h>
+#include <sfl/flat_sequence.h>
+#include <sfl/profiler.h>
+#include <sfl/utilities.h>
+
+// OpenCV
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+
+using std::cout;
+using std::endl;
+using std::cerr;
+using std::string;
+using std::runtime_error;
+using namespace boost::program_options;
+using namespace boost::filesystem;
+
+typedef std::chrono::steady_clock bench_clock;
+
+/** Result of a single benchmark case.
+*/
+struct BenchResult
+{
+    string name;
+    size_t items_per_iteration = 1;             ///< Frames (or faces) processed per iteration.
+    std::vector<double> samples;                ///< Latency of each iteration [ms].
+    std::map<string, std::vector<double>> stages;   ///< Latency of each stage per iteration [ms].
+    std::vector<double> errors;                 ///< Landmarks error of each frame [pixels].
+    string skipped;                             ///< Reason the case was skipped.
+    string failed;                              ///< Reason a behaviour check failed.
+};
+
+/** Peak resident set size of the process [KB].
+The peak never decreases, so it is reported once for the whole run rather than
+for each benchmark case.
+*/
+long getPeakRSS()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return (long)(usage.ru_maxrss / 1024);  // Bytes on macOS
+#else
+    return (long)usage.ru_maxrss;
+#endif
+#endif
+}
+
+double elapsedMS(const bench_clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+}
+
+/** Nearest rank percentile of sorted samples.
+*/
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) return 0;
+    size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+    return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+/** Deterministic textured frame, blurred noise has enough corners for BRISK.
+*/
+cv::Mat createSyntheticFrame(cv::RNG& rng, const cv::Size& size)
+{
+    cv::Mat frame(size, CV_8UC3);
+    rng.fill(frame, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+    cv::GaussianBlur(frame, frame, cv::Size(5, 5), 0);
+    return frame;
+}
+
+/** Deterministic face with 68 landmarks inside a bounding box.
+The landmarks follow the layout of the 68 points model (jaw, brows, nose, eyes and
+mouth) so rendering and the face utilities behave as with real faces.
+*/
+std::unique_ptr<sfl::Face> createSyntheticFace(cv::RNG& rng, const cv::Rect& bbox, int id)
+{
+    std::unique_ptr<sfl::Face> face = std::make_unique<sfl::Face>();
+    face->id = id;
+    face->bbox = bbox;
+    face->landmarks.resize(68);
+    auto at = [&bbox, &rng](float x, float y)
+    {
+        return cv::Point(bbox.x + (int)std::round(x * bbox.width) + rng.uniform(-1, 2),
+            bbox.y + (int)std::round(y * bbox.height) + rng.uniform(-1, 2));
+    };
+    const float pi = 3.14159265f;
+    for (int i = 0; i <= 16; ++i)   // Jaw
+    {
+        float a = pi * i / 16.0f;
+        face->landmarks[i] = at(0.5f - 0.45f * std::cos(a), 0.35f + 0.6f * std::sin(a));
+    }
+    for (int i = 0; i < 5; ++i)     // Brows
+    {
+        face->landmarks[17 + i] = at(0.15f + 0.07f * i, 0.25f);
+        face->landmarks[22 + i] = at(0.57f + 0.07f * i, 0.25f);
+    }
+    for (int i = 0; i < 4; ++i)     // Nose bridge
+        face->landmarks[27 + i] = at(0.5f, 0.35f + 0.07f * i);
+    for (int i = 0; i < 5; ++i)     // Nose bottom
+        face->landmarks[31 + i] = at(0.4f + 0.05f * i, 0.6f);
+    for (int i = 0; i < 6; ++i)     // Eyes
+    {
+        float a = 2 * pi * i / 6.0f;
+        face->landmarks[36 + i] = at(0.3f - 0.07f * std::cos(a), 0.35f - 0.03f * std::sin(a));
+        face->landmarks[42 + i] = at(0.7f - 0.07f * std::cos(a), 0.35f - 0.03f * std::sin(a));
+    }
+    for (int i = 0; i < 12; ++i)    // Outer lips
+    {
+        float a = 2 * pi * i / 12.0f;
+        face->landmarks[48 + i] = at(0.5f - 0.18f * std::cos(a), 0.75f - 0.07f * std::sin(a));
+    }
+    for (int i = 0; i < 8; ++i)     // Inner lips
+    {
+        float a = 2 * pi * i / 8.0f;
+        face->landmarks[60 + i] = at(0.5f - 0.12f * std::cos(a), 0.75f - 0.03f * std::sin(a));
+    }
+    return face;
+}
+
+/** Deterministic frame with faces laid out on a grid.
+*/
+std::unique_ptr<sfl::Frame> createSyntheticLandmarksFrame(cv::RNG& rng, const cv::Size& size,
+    int faces, int id)
+{
+    std::unique_ptr<sfl::Frame> frame = std::make_unique<sfl::Frame>();
+    frame->id = id;
+    frame->width = size.width;
+    frame->height = size.height;
+    int cols = (int)std::ceil(std::sqrt((double)faces));
+    int rows = (faces + cols - 1) / std::max(cols, 1);
+    int cell = std::min(size.width / std::max(cols, 1), size.height / std::max(rows, 1));
+    int face_size = cell * 3 / 4;
+    for (int i = 0; i < faces; ++i)
+    {
+        cv::Rect bbox((i % cols) * cell + (cell - face_size) / 2,
+            (i / cols) * cell + (cell - face_size) / 2, face_size, face_size);
+        frame->faces.push_back(createSyntheticFace(rng, bbox, i));
+    }
+    return frame;
+}
+
+void addStageSamples(const sfl::Profiler& profiler, BenchResult& result)
+{
+    for (int i = 0; i < sfl::PROFILE_STAGE_COUNT; ++i)
+    {
+        sfl::ProfileStage stage = (sfl::ProfileStage)i;
+        if (profiler.getStat(stage).calls == 0) continue;
+        result.stages[sfl::Profiler::getStageName(stage)].push_back(
+            profiler.getStat(stage).frame);
+    }
+}
+
+/** Measure addFrame on the frames of the clip resized to the specified resolution.
+The clip has real faces so the measurement includes landmarks prediction and
+tracking, not only the face detector.
+*/
+BenchResult benchAddFrame(const string& landmarksPath, const std::vector<cv::Mat>& clip,
+    const cv::Size& size, float frame_scale, int iterations, int warmup)
+{
+    BenchResult result;
+    result.name = (boost::format("add_frame/%dx%d/scale_%.2f") %
+        size.width % size.height % frame_scale).str();
+    if (landmarksPath.empty() || clip.empty())
+    {
+        result.skipped = "landmarks model or clip not specified";
+        return result;
+    }
+
+    std::shared_ptr<sfl::SequenceFaceLandmarks> sfl =
+        sfl::SequenceFaceLandmarks::create(landmarksPath, frame_scale);
+    std::shared_ptr<sfl::Profiler> profiler = std::make_shared<sfl::Profiler>();
+    sfl->setProfiler(profiler);
+    sfl->setFrameSink([](const sfl::Frame&) {});   // Don't accumulate frames
+
+    std::vector<cv::Mat> frames(clip.size());
+    for (size_t i = 0; i < clip.size(); ++i)
+        cv::resize(clip[i], frames[i], size, 0, 0, cv::INTER_AREA);
+
+    for (int i = 0; i < warmup; ++i) sfl->addFrame(frames[i % frames.size()]);
+    for (int i = 0; i < iterations; ++i)
+    {
+        bench_clock::time_point start = bench_clock::now();
+        sfl->addFrame(frames[i % frames.size()]);
+        result.samples.push_back(elapsedMS(start));
+        addStageSamples(*profiler, result);
+    }
+    return result;
+}
+
+/** Read the first frames of a video file.
+*/
+std::vector<cv::Mat> readClip(const string& clipPath, int frames)
+{
+    cv::VideoCapture video_reader(clipPath);
+    if (!video_reader.isOpened())
+        throw runtime_error("Failed to open \"" + clipPath + "\"!");
+    std::vector<cv::Mat> clip;
+    cv::Mat frame;
+    while ((int)clip.size() < frames && video_reader.read(frame))
+        clip.push_back(frame.clone());
+    return clip;
+}
+
+/** Mean distance between the landmarks of the faces of two frames [pixels].
+The faces are compared in order, as they are found by the same face detector.
+Returns a negative value if the frames can't be compared.
+*/
+double landmarksError(const sfl::Frame& frame, const sfl::FlatSequence::FrameView& reference)
+{
+    if (frame.faces.size() != reference.size()) return -1.0;
+    double error = 0;
+    size_t count = 0, i = 0;
+    for (auto& face : frame.faces)
+    {
+        sfl::FlatSequence::FaceView ref_face = reference[i++];
+        const cv::Point* ref_landmarks = ref_face.landmarks();
+        if (face->landmarks.size() != ref_face.landmarksCount()) return -1.0;
+        for (size_t j = 0; j < face->landmarks.size(); ++j)
+            error += cv::norm(cv::Point2f(face->landmarks[j]) - cv::Point2f(ref_landmarks[j]));
+        count += face->landmarks.size();
+    }
+    return count > 0 ? error / count : -1.0;
+}
+
+string getPredictorName(sfl::ShapePredictorEngine engine, int cascades, int trees)
+{
+    return (boost::format("predictor/%scascades_%s/trees_%s") %
+        (engine == sfl::PREDICTOR_PACKED ? "packed/" : "") %
+        (cascades > 0 ? std::to_string(cascades) : "all") %
+        (trees > 0 ? std::to_string(trees) : "all")).str();
+}
+
+/** Measure the speed and the landmarks error of a reduced shape predictor.
+The error is measured against the full shape predictor on the same frames.
+*/
+BenchResult benchPredictor(const string& landmarksPath, const std::vector<cv::Mat>& clip,
+    const sfl::FlatSequence& reference, sfl::ShapePredictorEngine engine,
+    int cascades, int trees, int warmup)
+{
+    BenchResult result;
+    result.name = getPredictorName(engine, cascades, trees);
+    if (landmarksPath.empty() || clip.empty())
+    {
+        result.skipped = "landmarks model or clip not specified";
+        return result;
+    }
+
+    std::shared_ptr<sfl::SequenceFaceLandmarks> sfl =
+        sfl::SequenceFaceLandmarks::create(landmarksPath);
+    std::shared_ptr<sfl::Profiler> profiler = std::make_shared<sfl::Profiler>();
+    sfl->setPredictorCascades(cascades);
+    sfl->setPredictorTrees(trees);
+    sfl->setPredictorEngine(engine);
+    sfl->setProfiler(profiler);
+    sfl->setFrameSink([](const sfl::Frame&) {});   // Don't accumulate frames
+
+    for (int i = 0; i < warmup; ++i) sfl->addFrame(clip[i % clip.size()]);
+    for (size_t i = 0; i < clip.size(); ++i)
+    {
+        bench_clock::time_point start = bench_clock::now();
+        const sfl::Frame& frame = sfl->addFrame(clip[i]);
+        result.samples.push_back(elapsedMS(start));
+        addStageSamples(*profiler, result);
+        double error = landmarksError(frame, reference[i]);
+        if (error >= 0) result.errors.push_back(error);
+    }
+    return result;
+}
+
+/** Measure DETECTION_FLOW mode with the propagated landmarks refined by the last
+cascade stages. The error is measured against the full shape predictor on the same
+frames. The shape prediction time per face of the frames found by optical flow is
+checked to be lower than that of the keyframes, which run the full cascade.
+*/
+BenchResult benchFlowRefine(const string& landmarksPath, const std::vector<cv::Mat>& clip,
+    const sfl::FlatSequence& reference, int cascades, int warmup)
+{
+    BenchResult result;
+    result.name = (boost::format("flow/refine_%d") % cascades).str();
+    if (landmarksPath.empty() || clip.empty())
+    {
+        result.skipped = "landmarks model or clip not specified";
+        return result;
+    }
+
+    std::shared_ptr<sfl::SequenceFaceLandmarks> sfl =
+        sfl::SequenceFaceLandmarks::create(landmarksPath);
+    std::shared_ptr<sfl::Profiler> profiler = std::make_shared<sfl::Profiler>();
+    sfl->setDetectionMode(sfl::DETECTION_FLOW);
+    sfl->setFlowRefineCascades(cascades);
+    sfl->setProfiler(profiler);
+    sfl->setFrameSink([](const sfl::Frame&) {});   // Don't accumulate frames
+
+    for (int i = 0; i < warmup; ++i) sfl->addFrame(clip[i % clip.size()]);
+    sfl->clear();
+    std::vector<double> flow_times, full_times;     // Shape prediction per face [ms]
+    for (size_t i = 0; i < clip.size(); ++i)
+    {
+        bench_clock::time_point start = bench_clock::now();
+        const sfl::Frame& frame = sfl->addFrame(clip[i]);
+        result.samples.push_back(elapsedMS(start));
+        addStageSamples(*profiler, result);
+        double error = landmarksError(frame, reference[i]);
+        if (error >= 0) result.errors.push_back(error);
+
+        // Frames found by optical flow don't run the detector
+        if (frame.faces.empty()) continue;
+        bool flow = profiler->getStat(sfl::PROFILE_OPTICAL_FLOW).frame > 0;
+        bool detection = profiler->getStat(sfl::PROFILE_DETECTION).frame > 0;
+        double time = profiler->getStat(sfl::PROFILE_SHAPE_PREDICTION).frame /
+            frame.faces.size();
+        if (flow && !detection) flow_times.push_back(time);
+        else if (detection && !flow) full_times.push_back(time);
+    }
+
+    if (!flow_times.empty() && !full_times.empty())
+    {
+        double flow_mean = std::accumulate(flow_times.begin(), flow_times.end(), 0.0) /
+            flow_times.size();
+        double full_mean = std::accumulate(full_times.begin(), full_times.end(), 0.0) /
+            full_times.size();
+        if (flow_mean >= full_mean)
+            result.failed = (boost::format("shape prediction on flow frames (%.3f ms per "
+                "face) is not faster than on keyframes (%.3f ms per face)") %
+                flow_mean % full_mean).str();
+    }
+    return result;
+}
+
+const char* getTrackerName(sfl::FaceTrackingType tracking)
+{
+    switch (tracking)
+    {
+    case sfl::TRACKING_BRISK: return "brisk";
+    case sfl::TRACKING_LBP: return "lbp";
+    case sfl::TRACKING_MOTION: return "motion";
+    default: return "none";
+    }
+}
+
+BenchResult benchTracker(sfl::FaceTrackingType tracking, int faces, int iterations,
+    int warmup, uint64_t seed)
+{
+    BenchResult result;
+    result.name = (boost::format("tracker/%s/faces_%d") %
+        getTrackerName(tracking) % faces).str();
+    result.items_per_iteration = 1;
+
+    std::shared_ptr<sfl::FaceTracker> tracker;
+    try
+    {
+        if (tracking == sfl::TRACKING_BRISK) tracker = sfl::createFaceTrackerBRISK();
+        else if (tracking == sfl::TRACKING_LBP) tracker = sfl::createFaceTrackerLBP();
+        else tracker = sfl::createFaceTrackerMotion();
+    }
+    catch (std::exception& e)
+    {
+        result.skipped = e.what();
+        return result;
+    }
+    std::shared_ptr<sfl::Profiler> profiler = std::make_shared<sfl::Profiler>();
+    tracker->setProfiler(profiler);
+
+    // The faces jitter slightly between frames
+    const cv::Size size(1280, 720);
+    cv::RNG rng(seed);
+    cv::Mat frame = createSyntheticFrame(rng, size);
+    std::vector<std::unique_ptr<sfl::Frame>> sfl_frames;
+    for (int i = 0; i < warmup + iterations; ++i)
+        sfl_frames.push_back(createSyntheticLandmarksFrame(rng, size, faces, i));
+
+    for (int i = 0; i < warmup + iterations; ++i)
+    {
+        bench_clock::time_point start = bench_clock::now();
+        tracker->addFrame(frame, *sfl_frames[i]);
+        double ms = elapsedMS(start);
+        profiler->endFrame();
+        if (i < warmup) continue;
+        result.samples.push_back(ms);
+        addStageSamples(*profiler, result);
+    }
+    return result;
+}
+
+void createSyntheticSequence(std::list<std::unique_ptr<sfl::Frame>>& sequence,
+    int frames, int faces, uint64_t seed)
+{
+    cv::RNG rng(seed);
+    for (int i = 0; i < frames; ++i)
+        sequence.push_back(createSyntheticLandmarksFrame(rng, cv::Size(1280, 720),
+            faces, i));
+}
+
+std::vector<BenchResult> benchSaveLoad(int frames, int faces, int iterations, uint64_t seed)
+{
+    std::vector<BenchResult> results(2);
+    results[0].name = (boost::format("lms/save/frames_%d/faces_%d") % frames % faces).str();
+    results[1].name = (boost::format("lms/load/frames_%d/faces_%d") % frames % faces).str();
+    results[0].items_per_iteration = results[1].items_per_iteration = frames;
+
+    std::shared_ptr<sfl::SequenceFaceLandmarks> sfl = sfl::SequenceFaceLandmarks::create();
+    createSyntheticSequence(sfl->getSequenceMutable(), frames, faces, seed);
+    path filePath = temp_directory_path() / unique_path("sfl_bench_%%%%-%%%%.lms");
+
+    try
+    {
+        std::shared_ptr<sfl::SequenceFaceLandmarks> loaded = sfl::SequenceFaceLandmarks::create();
+        for (int i = 0; i < iterations; ++i)
+        {
+            bench_clock::time_point start = bench_clock::now();
+            sfl->save(filePath.string());
+            results[0].samples.push_back(elapsedMS(start));
+
+            start = bench_clock::now();
+            loaded->load(filePath.string());
+            results[1].samples.push_back(elapsedMS(start));
+        }
+        if (loaded->size() != (size_t)frames)
+            throw runtime_error("Loaded sequence doesn't match the saved sequence!");
+    }
+    catch (std::exception& e)
+    {
+        results[0].skipped = results[1].skipped = e.what();
+        results[0].samples.clear();
+        results[1].samples.clear();
+    }
+    if (exists(filePath)) boost::filesystem::remove(filePath);
+
+    return results;
+}
+
+std::vector<BenchResult> benchSequenceStats(int frames, int faces, int iterations, uint64_t seed)
+{
+    std::vector<BenchResult> results(2);
+    results[0].name = (boost::format("sequence_stats/list/frames_%d/faces_%d") %
+        frames % faces).str();
+    results[1].name = (boost::format("sequence_stats/flat/frames_%d/faces_%d") %
+        frames % faces).str();
+    results[0].items_per_iteration = results[1].items_per_iteration = frames;
+
+    std::list<std::unique_ptr<sfl::Frame>> sequence;
+    createSyntheticSequence(sequence, frames, faces, seed);
+    sfl::FlatSequence flat(sequence);
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        std::vector<sfl::FaceStat> stats;
+        bench_clock::time_point start = bench_clock::now();
+        sfl::getSequenceStats(sequence, stats);
+        results[0].samples.push_back(elapsedMS(start));
+
+        stats.clear();
+        start = bench_clock::now();
+        sfl::getSequenceStats(flat, stats);
+        results[1].samples.push_back(elapsedMS(start));
+    }
+
+    return results;
+}
+
+BenchResult benchRender(int faces, int iterations, uint64_t seed)
+{
+    BenchResult result;
+    result.name = (boost::format("render/faces_%d") % faces).str();
+
+    const cv::Size size(1280, 720);
+    cv::RNG rng(seed);
+    cv::Mat frame = createSyntheticFrame(rng, size), canvas;
+    std::unique_ptr<sfl::Frame> sfl_frame = createSyntheticLandmarksFrame(rng, size, faces, 0);
+    for (int i = 0; i < iterations; ++i)
+    {
+        frame.copyTo(canvas);
+        bench_clock::time_point start = bench_clock::now();
+        sfl::render(canvas, *sfl_frame);
+        result.samples.push_back(elapsedMS(start));
+    }
+    return result;
+}
+
+void writeLatency(std::ostream& out, std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    out << "{\"mean\": " << mean << ", \"min\": " << samples.front() <<
+        ", \"p50\": " << percentile(samples, 50) << ", \"p90\": " << percentile(samples, 90) <<
+        ", \"p99\": " << percentile(samples, 99) << ", \"max\": " << samples.back() << "}";
+}
+
+void writeJSON(std::ostream& out, const std::vector<BenchResult>& results,
+    int iterations, uint64_t seed)
+{
+    out << std::setprecision(6);
+    out << "{" << endl;
+    out << "  \"seed\": " << seed << "," << endl;
+    out << "  \"iterations\": " << iterations << "," << endl;
+    out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << "," << endl;
+    out << "  \"peak_rss_kb\": " << getPeakRSS() << "," << endl;
+    out << "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult& result = results[i];
+        out << (i > 0 ? "," : "") << endl << "    {\"name\": \"" << result.name << "\"";
+        if (!result.failed.empty())
+        {
+            string reason = result.failed;
+            std::replace(reason.begin(), reason.end(), '"', '\'');
+            out << ", \"failed\": \"" << reason << "\"";
+        }
+        if (!result.skipped.empty() || result.samples.empty())
+        {
+            string reason = result.skipped;
+            std::replace(reason.begin(), reason.end(), '"', '\'');
+            out << ", \"skipped\": \"" << reason << "\"}";
+            continue;
+        }
+
+        double total = std::accumulate(result.samples.begin(), result.samples.end(), 0.0);
+        double fps = total > 0 ?
+            1000.0 * result.samples.size() * result.items_per_iteration / total : 0;
+        out << ", \"iterations\": " << result.samples.size() <<
+            ", \"frames_per_iteration\": " << result.items_per_iteration <<
+            ", \"fps\": " << fps << "," << endl;
+        out << "     \"latency_ms\": ";
+        writeLatency(out, result.samples);
+        if (!result.stages.empty())
+        {
+            out << "," << endl << "     \"stages_ms\": {";
+            bool first = true;
+            for (auto& stage : result.stages)
+            {
+                out << (first ? "" : ",") << endl << "       \"" << stage.first << "\": ";
+                writeLatency(out, stage.second);
+                first = false;
+            }
+            out << "}";
+        }
+        if (!result.errors.empty())
+        {
+            out << "," << endl << "     \"landmarks_error_px\": ";
+            writeLatency(out, result.errors);
+        }
+        out << "}";
+    }
+    out << endl << "  ]" << endl << "}" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	// Parse command line arguments
+    string landmarksModelPath, clipPath, outputPath, filter;
+    int iterations, warmup, frames;
+    uint64_t seed;
+	try {
+		options_description desc("Allowed options");
+		desc.add_options()
+			("help", "display the help message")
+            ("landmarks,l", value<string>(&landmarksModelPath),
+                "path to landmarks model file, addFrame benchmarks are skipped without it")
+            ("clip,c", value<string>(&clipPath),
+                "path to a video with faces, addFrame and predictor benchmarks are skipped without it")
+			("output,o", value<string>(&outputPath), "output JSON path (default: stdout)")
+            ("iterations,n", value<int>(&iterations)->default_value(30),
+                "number of measured iterations per benchmark")
+            ("warmup,w", value<int>(&warmup)->default_value(3),
+                "number of unmeasured iterations per benchmark")
+            ("frames,f", value<int>(&frames)->default_value(1000),
+                "number of frames in the sequence benchmarks")
+            ("seed", value<uint64_t>(&seed)->default_value(0), "random seed for the inputs")
+            ("filter", value<string>(&filter), "run only benchmarks with names containing this")
+			;
+		variables_map vm;
+		store(command_line_parser(argc, argv).options(desc).run(), vm);
+		if (vm.count("help")) {
+			cout << "Usage: sfl_bench [options]" << endl;
+			cout << desc << endl;
+			exit(0);
+		}
+		notify(vm);
+        if (!landmarksModelPath.empty() && !is_regular_file(landmarksModelPath))
+            throw error("landmarks must be a path to a file!");
+        if (!clipPath.empty() && !is_regular_file(clipPath))
+            throw error("clip must be a path to a file!");
+        if (iterations < 1) throw error("iterations must be positive!");
+	}
+	catch (const error& e) {
+		cout << "Error while parsing command-line arguments: " << e.what() << endl;
+		cout << "Use --help to display a list of options." << endl;
+		exit(1);
+	}
+
+	try
+	{
+        std::vector<BenchResult> results;
+        auto run = [&filter](const string& name) {
+            return filter.empty() || name.find(filter) != string::npos;
+        };
+        auto add = [&results](BenchResult result)
+        {
+            cerr << result.name << (result.skipped.empty() ? "" : " (skipped)") << endl;
+            if (!result.failed.empty()) cerr << "  failed: " << result.failed << endl;
+            results.push_back(std::move(result));
+        };
+
+        // The clip is read once, only if a benchmark needs it
+        std::vector<cv::Mat> clip;
+        auto getClip = [&clip, &clipPath, iterations]() -> const std::vector<cv::Mat>&
+        {
+            if (clip.empty() && !clipPath.empty()) clip = readClip(clipPath, iterations);
+            return clip;
+        };
+
+        // Landmarks extraction
+        const std::vector<cv::Size> resolutions = {
+            { 320, 240 }, { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+        const std::vector<float> frame_scales = { 0.5f, 1.0f, 2.0f };
+        for (const cv::Size& size : resolutions)
+            for (float frame_scale : frame_scales)
+                if (run((boost::format("add_frame/%dx%d/scale_%.2f") %
+                    size.width % size.height % frame_scale).str()))
+                    add(benchAddFrame(landmarksModelPath, getClip(), size, frame_scale,
+                        iterations, warmup));
+
+        // Shape predictor speed and accuracy trade off, the error is measured
+        // against the full predictor on the first frames of the clip
+        const std::vector<std::pair<int, int>> settings = {
+            { 0, 0 }, { 8, 0 }, { 6, 0 }, { 4, 0 }, { 0, 250 }, { 0, 100 }, { 6, 250 } };
+        std::vector<std::tuple<sfl::ShapePredictorEngine, int, int>> predictor_cases;
+        for (sfl::ShapePredictorEngine engine : { sfl::PREDICTOR_DLIB, sfl::PREDICTOR_PACKED })
+            for (auto& setting : settings)
+                if (run(getPredictorName(engine, setting.first, setting.second)))
+                    predictor_cases.emplace_back(engine, setting.first, setting.second);
+        std::vector<int> flow_cases;
+        for (int cascades : { 1, 3, 5 })
+            if (run((boost::format("flow/refine_%d") % cascades).str()))
+                flow_cases.push_back(cascades);
+        if (!predictor_cases.empty() || !flow_cases.empty())
+        {
+            sfl::FlatSequence reference;
+            if (!landmarksModelPath.empty() && !getClip().empty())
+            {
+                std::shared_ptr<sfl::SequenceFaceLandmarks> sfl =
+                    sfl::SequenceFaceLandmarks::create(landmarksModelPath);
+                sfl->setFrameSink([&reference](const sfl::Frame& frame)
+                {
+                    reference.append(frame);
+                });
+                for (const cv::Mat& frame : clip) sfl->addFrame(frame);
+            }
+
+            for (auto& predictor_case : predictor_cases)
+                add(benchPredictor(landmarksModelPath, clip, reference,
+                    std::get<0>(predictor_case), std::get<1>(predictor_case),
+                    std::get<2>(predictor_case), warmup));
+            for (int cascades : flow_cases)
+                add(benchFlowRefine(landmarksModelPath, clip, reference, cascades, warmup));
+        }
+
+        // Tracking
+        const std::vector<int> face_counts = { 1, 5, 10, 25, 50 };
+        for (sfl::FaceTrackingType tracking :
+            { sfl::TRACKING_BRISK, sfl::TRACKING_LBP, sfl::TRACKING_MOTION })
+            for (int faces : face_counts)
+                if (run((boost::format("tracker/%s/faces_%d") %
+                    getTrackerName(tracking) % faces).str()))
+                    add(benchTracker(tracking, faces, iterations, warmup, seed));
+
+        // Sequence file and sequence utilities, each measures a pair of cases
+        auto runPair = [&run, frames](const char* format, const char* first, const char* second)
+        {
+            return run((boost::format(format) % first % frames % 5).str()) ||
+                run((boost::format(format) % second % frames % 5).str());
+        };
+        if (runPair("lms/%s/frames_%d/faces_%d", "save", "load"))
+            for (BenchResult& result : benchSaveLoad(frames, 5, iterations, seed))
+                if (run(result.name)) add(std::move(result));
+        if (runPair("sequence_stats/%s/frames_%d/faces_%d", "list", "flat"))
+            for (BenchResult& result : benchSequenceStats(frames, 5, iterations, seed))
+                if (run(result.name)) add(std::move(result));
+        for (int faces : { 1, 10, 50 })
+            if (run((boost::format("render/faces_%d") % faces).str()))
+                add(benchRender(faces, iterations, seed));
+
+        // Output results
+        if (outputPath.empty()) writeJSON(cout, results, iterations, seed);
+        else
+        {
+            std::ofstream output(outputPath);
+            if (!output) throw runtime_error("Failed to open \"" + outputPath + "\"!");
+            writeJSON(output, results, iterations, seed);
+        }
+        for (const BenchResult& result : results)
+            if (!result.failed.empty()) return 1;
+	}
+	catch (std::exception& e)
+	{
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
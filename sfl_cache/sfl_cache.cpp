@@ -1,6 +1,8 @@
 // std
 #include <iostream>
 #include <exception>
+#include <future>
+#include <thread>
 
 // Boost
 #include <boost/program_options.hpp>
@@ -9,6 +11,10 @@
 
 // sfl
 #include <sfl/sequence_face_landmarks.h>
+#include <sfl/sequence_io.h>
+#include <sfl/landmarks_cache.h>
+#include <sfl/profiler.h>
+#include <sfl/thread_pool.h>
 #include <sfl/utilities.h>
 
 // OpenCV
@@ -29,8 +35,12 @@ int main(int argc, char* argv[])
 	// Parse command line arguments
 	string inputPath, outputPath, landmarksModelPath;
 	std::vector<float> frame_scales;
-    unsigned int track;
-	bool preview;
+    unsigned int track, detect_mode, detect_interval;
+    int predictor_cascades, predictor_trees, flow_cascades;
+    unsigned int predictor_engine;
+    int min_face_size, max_face_size;
+    int max_age, max_lost;
+	bool preview, stream, index, profile, adaptive;
 	try {
 		options_description desc("Allowed options");
 		desc.add_options()
@@ -40,9 +50,38 @@ int main(int argc, char* argv[])
 			("landmarks,l", value<string>(&landmarksModelPath)->required(), "path to landmarks model file")
 			("scales,s", value<std::vector<float>>(&frame_scales)->default_value({ 1.0f }, "{1}"),
 				"frame scales for finding small faces. Best scale will be selected")
+            ("adaptive", value<bool>(&adaptive)->default_value(false)->implicit_value(true),
+                "process once at the first scale and escalate to the other scales only "
+                "in frames with fewer faces than usual")
 			("track,t", value<unsigned int>(&track)->default_value(1), 
-                "track faces across frames [0=NONE|1=BRISK|2=LBP]")
+                "track faces across frames [0=NONE|1=BRISK|2=LBP|3=MOTION]")
+            ("max_age", value<int>(&max_age)->default_value(0),
+                "forget faces not seen for this many frames [0=unlimited]")
+            ("max_lost", value<int>(&max_lost)->default_value(-1),
+                "maximum number of lost faces kept for re-identification [-1=unlimited]")
+            ("detect_mode,m", value<unsigned int>(&detect_mode)->default_value(0),
+                "face detection mode [0=FULL|1=KEYFRAMES|2=ROI|3=FLOW]")
+            ("detect_interval,d", value<unsigned int>(&detect_interval)->default_value(10),
+                "number of frames between full face detections in KEYFRAMES, ROI and FLOW modes")
+            ("cascades", value<int>(&predictor_cascades)->default_value(0),
+                "number of shape predictor cascade stages to evaluate, fewer is faster [0=all]")
+            ("trees", value<int>(&predictor_trees)->default_value(0),
+                "number of trees to evaluate in each cascade stage, fewer is faster [0=all]")
+            ("flow_cascades", value<int>(&flow_cascades)->default_value(3),
+                "number of shape predictor cascade stages refining the landmarks in FLOW mode")
+            ("engine", value<unsigned int>(&predictor_engine)->default_value(0),
+                "shape predictor evaluation engine [0=DLIB|1=PACKED]")
+            ("min_face", value<int>(&min_face_size)->default_value(0),
+                "minimum face size in pixels, larger is faster [0=no limit]")
+            ("max_face", value<int>(&max_face_size)->default_value(0),
+                "maximum face size in pixels, smaller is faster [0=no limit]")
 			("preview,p", value<bool>(&preview)->default_value(true), "preview landmarks")
+            ("stream", value<bool>(&stream)->default_value(false)->implicit_value(true),
+                "write the landmarks while processing instead of keeping them in memory")
+            ("index", value<bool>(&index)->default_value(false)->implicit_value(true),
+                "also write a random access landmarks cache (.lmc) next to the output")
+            ("profile", value<bool>(&profile)->default_value(false)->implicit_value(true),
+                "print the time spent in each processing stage")
 			;
 		variables_map vm;
 		store(command_line_parser(argc, argv).options(desc).
@@ -54,6 +93,8 @@ int main(int argc, char* argv[])
 		}
 		notify(vm);
 		if (!is_regular_file(landmarksModelPath)) throw error("landmarks must be a path to a file!");
+        if (detect_mode > 3) throw error("detect_mode must be either 0, 1, 2 or 3!");
+        if (predictor_engine > 1) throw error("engine must be either 0 or 1!");
 	}
 	catch (const error& e) {
 		cout << "Error while parsing command-line arguments: " << e.what() << endl;
@@ -64,83 +105,207 @@ int main(int argc, char* argv[])
 	try
 	{
 		// Initialize Sequence Face Landmarks
-		std::vector<std::shared_ptr<sfl::SequenceFaceLandmarks>> sfls(frame_scales.size());
+		std::vector<std::shared_ptr<sfl::SequenceFaceLandmarks>> sfls(
+            adaptive ? 1 : frame_scales.size());
 		sfls[0] = sfl::SequenceFaceLandmarks::create(landmarksModelPath, frame_scales[0],
             (sfl::FaceTrackingType)track);
-		for (int i = 1; i < frame_scales.size(); ++i)
+        sfls[0]->setTrackingMaxAge(max_age);
+        sfls[0]->setTrackingMaxLost(max_lost);
+        sfls[0]->setDetectionMode((sfl::FaceDetectionMode)detect_mode);
+        sfls[0]->setDetectionInterval((int)detect_interval);
+        sfls[0]->setPredictorCascades(predictor_cascades);
+        sfls[0]->setPredictorTrees(predictor_trees);
+        sfls[0]->setFlowRefineCascades(flow_cascades);
+        sfls[0]->setPredictorEngine((sfl::ShapePredictorEngine)predictor_engine);
+        sfls[0]->setMinFaceSize(min_face_size);
+        sfls[0]->setMaxFaceSize(max_face_size);
+        if (adaptive) sfls[0]->setAdaptiveScales(
+            std::vector<float>(frame_scales.begin() + 1, frame_scales.end()));
+		for (int i = 1; i < sfls.size(); ++i)
 		{
 			sfls[i] = sfls[0]->clone();
 			sfls[i]->setFrameScale(frame_scales[i]);
 		}
 
-		int max_faces = 0;
-		std::shared_ptr<sfl::SequenceFaceLandmarks> best_sfl;
+        // Split the hardware threads between the scales
+        int threads = std::max((int)std::thread::hardware_concurrency() / (int)sfls.size(), 1);
+        for (auto& sfl : sfls) sfl->setThreads(threads);
+
+        // Time each scale separately
+        std::vector<std::shared_ptr<sfl::Profiler>> profilers(sfls.size());
+        if (profile)
+        {
+            for (size_t i = 0; i < sfls.size(); ++i)
+            {
+                profilers[i] = std::make_shared<sfl::Profiler>();
+                sfls[i]->setProfiler(profilers[i]);
+            }
+        }
+
+        // Set output path
+        path input = path(inputPath);
+        if (outputPath.empty()) outputPath =
+            (input.parent_path() / (input.stem() += ".lms")).string();
+        else if (is_directory(outputPath)) outputPath =
+            (path(outputPath) / (input.stem() += ".lms")).string();
+
+        // Stream each scale to its own file, the best one will be renamed to the output path
+        std::vector<std::shared_ptr<sfl::SequenceWriter>> writers(sfls.size());
+        std::vector<string> streamPaths(sfls.size());
+        std::vector<int> streamedFaces(sfls.size(), 0);
+        if (stream)
+        {
+            for (size_t i = 0; i < sfls.size(); ++i)
+            {
+                streamPaths[i] = outputPath + "." + std::to_string(i) + ".tmp";
+                writers[i] = sfl::SequenceWriter::create(streamPaths[i], inputPath);
+                sfl::SequenceWriter* writer = writers[i].get();
+                int* faceCounter = &streamedFaces[i];
+                sfls[i]->setFrameSink([writer, faceCounter](const sfl::Frame& landmarks_frame)
+                {
+                    writer->write(landmarks_frame);
+                    *faceCounter += landmarks_frame.faces.size();
+                });
+            }
+        }
 
-		// For each sfl configuration
-		for (auto& sfl : sfls)
+		// Create video source
+		cv::VideoCapture video_reader(inputPath);
+
+		// Main loop, each frame is decoded once and processed in all scales
+		cv::Mat frame;
+		int frameCounter = 0;
+        std::vector<int> faceCounters(sfls.size(), 0);
+        size_t best_ind = 0;
+
+        // The scales of each frame are processed concurrently by a worker per scale
+        sfl::ThreadPool scale_pool((int)sfls.size());
+		while (video_reader.read(frame))
 		{
-			// Create video source
-			cv::VideoCapture video_reader(inputPath);
+            if (!preview)
+            {
+                // Frames that depend on the previous frame are processed synchronously
+                // by addFrameAsync, so the scales are still run in parallel
+                if (sfls.size() == 1)
+                {
+                    sfls[0]->addFrameAsync(frame);
+                    continue;
+                }
+                std::vector<std::future<void>> queued;
+                queued.reserve(sfls.size());
+                for (auto& sfl : sfls)
+                    queued.push_back(scale_pool.enqueue(
+                        [&sfl, &frame](int) { sfl->addFrameAsync(frame); }));
+                for (auto& result : queued) result.get();
+                continue;
+            }
 
-			// Main loop
-			cv::Mat frame;
-			int frameCounter = 0, faceCounter = 0;
-			while (video_reader.read(frame))
-			{
-				const sfl::Frame& landmarks_frame = sfl->addFrame(frame);
-                faceCounter += landmarks_frame.faces.size();
-
-				if (preview)
-				{
-					// Render landmarks
-					sfl::render(frame, landmarks_frame);
-
-					// Render overlay
-					string msg = "Frame count: " + std::to_string(++frameCounter);
-					cv::putText(frame, msg, cv::Point(15, 15),
-						cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 102, 255), 1, CV_AA);
-					msg = "Faces found so far: " + std::to_string(faceCounter);
-					cv::putText(frame, msg, cv::Point(15, 40),
-						cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 102, 255), 1, CV_AA);
-					msg = (boost::format("Current frame scale: %.1f") % sfl->getFrameScale()).str();
-					cv::putText(frame, msg, cv::Point(15, 65),
-						cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 102, 255), 1, CV_AA);
-					msg = "Tracking: " + std::string(track ? "Enabled" : "Disabled");
-					cv::putText(frame, msg, cv::Point(15, 90),
-						cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 102, 255), 1, CV_AA);
-					
-					cv::putText(frame, "press escape to stop", cv::Point(10, frame.rows - 20),
-						cv::FONT_HERSHEY_COMPLEX, 0.5, cv::Scalar(0, 102, 255), 1, CV_AA);
-
-					// Show frame
-					cv::imshow("sfl_cache", frame);
-					int key = cv::waitKey(1);
-					if (key == 27) break;
-				}
-			}
+            // Process all scales in parallel
+            std::vector<std::future<const sfl::Frame*>> results;
+            results.reserve(sfls.size());
+            for (auto& sfl : sfls)
+                results.push_back(scale_pool.enqueue(
+                    [&sfl, &frame](int) { return &sfl->addFrame(frame); }));
+            std::vector<const sfl::Frame*> landmarks_frames;
+            landmarks_frames.reserve(sfls.size());
+            for (size_t i = 0; i < results.size(); ++i)
+            {
+                landmarks_frames.push_back(results[i].get());
+                faceCounters[i] += landmarks_frames[i]->faces.size();
+                if (faceCounters[i] > faceCounters[best_ind]) best_ind = i;
+            }
+
+			// Render landmarks of the best scale so far
+			sfl::render(frame, *landmarks_frames[best_ind]);
+
+			// Render overlay
+			string msg = "Frame count: " + std::to_string(++frameCounter);
+			cv::putText(frame, msg, cv::Point(15, 15),
+				cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 102, 255), 1, CV_AA);
+			msg = "Faces found so far: " + std::to_string(faceCounters[best_ind]);
+			cv::putText(frame, msg, cv::Point(15, 40),
+				cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 102, 255), 1, CV_AA);
+			msg = (boost::format("Current frame scale: %.1f") % sfls[best_ind]->getFrameScale()).str();
+			cv::putText(frame, msg, cv::Point(15, 65),
+				cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 102, 255), 1, CV_AA);
+			msg = "Tracking: " + std::string(track ? "Enabled" : "Disabled");
+			cv::putText(frame, msg, cv::Point(15, 90),
+				cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 102, 255), 1, CV_AA);
+				
+			cv::putText(frame, "press escape to stop", cv::Point(10, frame.rows - 20),
+				cv::FONT_HERSHEY_COMPLEX, 0.5, cv::Scalar(0, 102, 255), 1, CV_AA);
+
+			// Show frame
+			cv::imshow("sfl_cache", frame);
+			int key = cv::waitKey(1);
+			if (key == 27) break;
+		}
+
+		// Select the scale that found the most faces
+		int max_faces = 0;
+		std::shared_ptr<sfl::SequenceFaceLandmarks> best_sfl;
+		for (size_t i = 0; i < sfls.size(); ++i)
+		{
+            sfls[i]->flush();
+            int faceCounter = streamedFaces[i];
+            if (!stream)
+            {
+                for (auto& landmarks_frame : sfls[i]->getSequence())
+                    faceCounter += landmarks_frame->faces.size();
+            }
 
 			if (faceCounter > max_faces || !best_sfl)
 			{
 				max_faces = faceCounter;
-				best_sfl = sfl;
+				best_sfl = sfls[i];
+                best_ind = i;
 			}
 		}
 		
+        // Print timing summary
+        for (size_t i = 0; i < profilers.size() && profile; ++i)
+        {
+            cout << "Profile of scale " <<
+                (boost::format("%.1f") % sfls[i]->getFrameScale()).str() << ":" << endl;
+            profilers[i]->print(cout);
+        }
+
 		if (best_sfl)
 		{
-			// Set output path
-			path input = path(inputPath);
-			if (outputPath.empty()) outputPath =
-				(input.parent_path() / (input.stem() += ".lms")).string();
-			else if (is_directory(outputPath)) outputPath =
-				(path(outputPath) / (input.stem() += ".lms")).string();
-
 			// Saving to file
 			cout << "Best scale: " << (boost::format("%.1f") % best_sfl->getFrameScale()).str() << endl;
 			cout << "Total faces found: " + std::to_string(max_faces) << endl;
 			cout << "Saving landmarks to \"" << outputPath << "\"." << endl;
-            best_sfl->setInputPath(inputPath);
-			best_sfl->save(outputPath);
+            if (stream)
+            {
+                for (size_t i = 0; i < writers.size(); ++i)
+                {
+                    writers[i]->close();
+                    if (i != best_ind) boost::filesystem::remove(streamPaths[i]);
+                }
+                if (exists(outputPath)) boost::filesystem::remove(outputPath);
+                boost::filesystem::rename(streamPaths[best_ind], outputPath);
+            }
+            else
+            {
+                best_sfl->setInputPath(inputPath);
+                best_sfl->save(outputPath);
+            }
+
+            // Write random access cache
+            if (index)
+            {
+                path cachePath = path(outputPath).replace_extension(".lmc");
+                cout << "Writing landmarks cache to \"" << cachePath.string() << "\"." << endl;
+                if (stream)
+                {
+                    std::shared_ptr<sfl::SequenceReader> reader =
+                        sfl::SequenceReader::create(outputPath);
+                    sfl::LandmarksCache::write(cachePath.string(), *reader);
+                }
+                else sfl::LandmarksCache::write(cachePath.string(),
+                    best_sfl->getSequence(), inputPath);
+            }
 		}
 	}
 	catch (std::exception& e)
@@ -9,6 +9,7 @@
 // sfl
 #include <sfl/sequence_face_landmarks.h>
 #include <sfl/face_tracker.h>
+#include <sfl/profiler.h>
 #include <sfl/utilities.h>
 
 // OpenCV
@@ -31,7 +32,8 @@ int main(int argc, char* argv[])
     std::vector<string> inputPaths;
 	string landmarksPath, outputPath, videoPath;
     unsigned int track;
-    bool preview;
+    int max_age, max_lost;
+    bool preview, profile;
 	try {
 		options_description desc("Allowed options");
 		desc.add_options()
@@ -40,8 +42,14 @@ int main(int argc, char* argv[])
                 "path to video or landmarks (.lms) files")
             ("output,o", value<string>(&outputPath), "output path")
             ("track,t", value<unsigned int>(&track)->default_value(1),
-                "track faces across frames [1=BRISK|2=LBP]")
+                "track faces across frames [1=BRISK|2=LBP|3=MOTION]")
+            ("max_age", value<int>(&max_age)->default_value(0),
+                "forget faces not seen for this many frames [0=unlimited]")
+            ("max_lost", value<int>(&max_lost)->default_value(-1),
+                "maximum number of lost faces kept for re-identification [-1=unlimited]")
             ("preview,p", value<bool>(&preview)->default_value(true), "preview landmarks")
+            ("profile", value<bool>(&profile)->default_value(false)->implicit_value(true),
+                "print the time spent in each tracking stage")
 			;
 		variables_map vm;
 		store(command_line_parser(argc, argv).options(desc).
@@ -73,8 +81,8 @@ int main(int argc, char* argv[])
             if (!is_regular_file(landmarksPath))
                 throw error("Couldn't find landmarks file!");
         }
-        if(track < 1 || track > 2)
-            throw error("track value must be either 1 for BRISK or 2 for LBP!");
+        if(track < 1 || track > 3)
+            throw error("track value must be either 1 for BRISK, 2 for LBP or 3 for MOTION!");
 	}
 	catch (const error& e) {
 		cout << "Error while parsing command-line arguments: " << e.what() << endl;
@@ -95,36 +103,54 @@ int main(int argc, char* argv[])
             cout << "Using BRISK face tracker." << endl;
             ft = sfl::createFaceTrackerBRISK();
         } 
-        else
+        else if (track == 2)
         {
             cout << "Using LBP face tracker." << endl;
             ft = sfl::createFaceTrackerLBP();
         }
+        else
+        {
+            cout << "Using motion face tracker." << endl;
+            ft = sfl::createFaceTrackerMotion();
+        }
+        ft->setMaxAge(max_age);
+        ft->setMaxLost(max_lost);
+        std::shared_ptr<sfl::Profiler> profiler;
+        if (profile)
+        {
+            profiler = std::make_shared<sfl::Profiler>();
+            ft->setProfiler(profiler);
+        }
 
-        // Validate video path
+        // Validate video path, the motion tracker doesn't need the video unless
+        // previewing
+        bool use_video = track != 3 || preview;
         if (videoPath.empty())
         {
             if (!sfl->getInputPath().empty()) videoPath = sfl->getInputPath();
-            if(!is_regular_file(videoPath))
+            if(!is_regular_file(videoPath) && use_video)
                 throw runtime_error("Couldn't find video sequence file!");
         }
         else if(is_regular_file(videoPath)) sfl->setInputPath(videoPath);
         else throw runtime_error("Couldn't find video sequence file!");
 
 		// Create video source
-		cv::VideoCapture video_reader(videoPath);
+		cv::VideoCapture video_reader;
+        if (use_video) video_reader.open(videoPath);
+        else cout << "Tracking without video." << endl;
 
 		// Preview loop
 		cv::Mat frame;
 		int frameCounter = 0, faceCounter = 0;
 		std::list<std::unique_ptr<sfl::Frame>>& sfl_frames = sfl->getSequenceMutable();
 		std::list<std::unique_ptr<sfl::Frame>>::iterator it = sfl_frames.begin();
-        while (it != sfl_frames.end() && video_reader.read(frame))
+        while (it != sfl_frames.end() && (!use_video || video_reader.read(frame)))
         {
             std::unique_ptr<sfl::Frame>& sfl_frame = *it++;
             faceCounter += sfl_frame->faces.size();
 
             ft->addFrame(frame, *sfl_frame);
+            if (profiler) profiler->endFrame();
 
             if (preview)
             {
@@ -148,10 +174,14 @@ int main(int argc, char* argv[])
             }
         }
 
+        // Print timing summary
+        if (profiler) profiler->print(cout);
+
         // Set output path
         if (outputPath.empty()) outputPath = landmarksPath;
         else if (is_directory(outputPath)) outputPath =
-            (path(outputPath) / (path(videoPath).stem() += ".lms")).string();
+            (path(outputPath) / (path(videoPath.empty() ? landmarksPath : videoPath).stem() +=
+                ".lms")).string();
 
         // Write output to file
         cout << "Saving landmarks to \"" << outputPath << "\"." << endl;
@@ -57,7 +57,8 @@ namespace sfl
 
     void Viewer::setInputPath(const std::string & input_path)
     {
-        if (path(input_path).extension() == ".lms")
+        path input = path(input_path);
+        if (input.extension() == ".lms" || input.extension() == ".lmc")
             initLandmarks(input_path);
         else initVideoSource(input_path);
     }
@@ -67,9 +68,19 @@ namespace sfl
         if (!is_regular_file(_landmarks_path)) return;
         if (landmarks_path == _landmarks_path) return;
 
-        sfl = sfl::SequenceFaceLandmarks::create(_landmarks_path);
+        // Landmarks cache files are memory mapped and read per frame
+        if (path(_landmarks_path).extension() == ".lmc")
+        {
+            landmarks_cache = sfl::LandmarksCache::open(_landmarks_path);
+            sfl = nullptr;
+        }
+        else
+        {
+            sfl = sfl::SequenceFaceLandmarks::create(_landmarks_path);
+            landmarks_cache = nullptr;
+        }
         landmarks_path = _landmarks_path;
-        initVideoSource(sfl->getInputPath());
+        initVideoSource(landmarks_cache ? landmarks_cache->getInputPath() : sfl->getInputPath());
         sm.process_event(EvStart());
     }
 
@@ -84,7 +95,9 @@ namespace sfl
 		{
 			sequence_path = _sequence_path;
 			path input = path(sequence_path);
-			initLandmarks((input.parent_path() / (input.stem() += ".lms")).string());
+			path cache_path = input.parent_path() / (input.stem() += ".lmc");
+			if (is_regular_file(cache_path)) initLandmarks(cache_path.string());
+			else initLandmarks((input.parent_path() / (input.stem() += ".lms")).string());
 			sm.process_event(EvStart());
 		}
     }
@@ -117,7 +130,7 @@ namespace sfl
             this,
             "Select one or more files to open",
             QString(),
-            "Landmarks (*.lms);;Videos (*.mp4 *.mkv *.avi *wmv);;All files (*.*)",
+            "Landmarks (*.lms *.lmc);;Videos (*.mp4 *.mkv *.avi *wmv);;All files (*.*)",
             nullptr);
         setInputPath(file.toStdString());
     }
@@ -152,12 +165,25 @@ namespace sfl
         sm.process_event(EvUpdate());
     }
 
+    const sfl::Frame* Viewer::getLandmarksFrame(int i)
+    {
+        if (landmarks_cache)
+        {
+            if (i < 0 || i >= (int)landmarks_cache->size()) return nullptr;
+            landmarks_cache->getFrame(i, cache_frame);
+            return &cache_frame;
+        }
+        if (i < 0 || i >= (int)sfl_frames.size()) return nullptr;
+        return sfl_frames[i];
+    }
+
     void Viewer::render()
     {
         // Render landmarks
         landmarks_render_frame = frame.clone();
 
-        for (auto& face : sfl_frames[curr_frame_pos]->faces)
+        const sfl::Frame* landmarks_frame = getLandmarksFrame(curr_frame_pos);
+        if (landmarks_frame) for (auto& face : landmarks_frame->faces)
         {
             if (actionShowLandmarks->isChecked())
                 sfl::render(landmarks_render_frame, face->landmarks, 
@@ -5,6 +5,7 @@
 #include "sfl_viewer_states.h"
 
 #include <sfl/sequence_face_landmarks.h>
+#include <sfl/landmarks_cache.h>
 
 #include <string>
 
@@ -25,6 +26,7 @@ namespace sfl
         void setInputPath(const std::string& input_path);
         void initLandmarks(const std::string& _landmarks_path);
         void initVideoSource(const std::string& _sequence_path);
+        const sfl::Frame* getLandmarksFrame(int i);
 
     protected:
         void resizeEvent(QResizeEvent* event) Q_DECL_OVERRIDE;
@@ -57,6 +59,8 @@ namespace sfl
         // sfl
         std::shared_ptr<sfl::SequenceFaceLandmarks> sfl;
         std::vector<sfl::Frame*> sfl_frames;
+        std::shared_ptr<sfl::LandmarksCache> landmarks_cache;
+        sfl::Frame cache_frame;
         cv::Scalar landmarks_color = cv::Scalar(0, 255, 0);
         cv::Scalar bbox_color = cv::Scalar(0, 0, 255);
 
@@ -31,7 +31,7 @@ int main(int argc, char* argv[])
         desc.add_options()
             ("help", "display the help message")
             ("input,i", value<std::vector<string>>(&inputPaths)->required(),
-                "path to video or landmarks (.lms) files")
+                "path to video or landmarks (.lms or .lmc) files")
                 ("draw_ind,d", value<bool>(&draw_ind)->default_value(false)->implicit_value(true),
                     "draw landmark indices")
             ;
@@ -32,7 +32,8 @@ namespace sfl
 
     sc::result Inactive::react(const EvStart &)
     {
-        if (viewer->video_reader == nullptr || viewer->sfl == nullptr)
+        if (viewer->video_reader == nullptr ||
+            (viewer->sfl == nullptr && viewer->landmarks_cache == nullptr))
         {
             QMessageBox msgBox;
             msgBox.setText("Failed to open sequence sources.");
@@ -84,12 +85,15 @@ namespace sfl
         QSize displaySize = viewer->display->size();
         viewer->render_frame = cv::Mat::zeros(displaySize.height(), displaySize.width(), CV_8UC3);
 
-        // Get sfl frames
-        const std::list<std::unique_ptr<Frame>>& sfl_frames_list = viewer->sfl->getSequence();
+        // Get sfl frames, cached landmarks are read per frame instead
         viewer->sfl_frames.clear();
-        viewer->sfl_frames.reserve(sfl_frames_list.size());
-        for (auto& frame : sfl_frames_list)
-            viewer->sfl_frames.push_back(frame.get());
+        if (viewer->sfl)
+        {
+            const std::list<std::unique_ptr<Frame>>& sfl_frames_list = viewer->sfl->getSequence();
+            viewer->sfl_frames.reserve(sfl_frames_list.size());
+            for (auto& frame : sfl_frames_list)
+                viewer->sfl_frames.push_back(frame.get());
+        }
 
         // Initialize widgets
         path title(path(viewer->sequence_path).filename() += path(" / ") +=